@@ -3,44 +3,84 @@
 #include "synth/synth.h"
 
 void AdditiveSynthComponent::update(Synth const & synth) {
+	using simd::float4;
+
 	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+	auto samples_per_step = SAMPLE_RATE / steps_per_second;
 	
 	update_voices(steps_per_second);
+
+	auto envelope = dsp::Envelope::from_steps(attack, hold, decay, sustain, release, samples_per_step);
+
+	float amplitudes[BLOCK_SIZE];
+
+	float4 harmonic_sums[BLOCK_SIZE]; // simd::WIDTH partial sums per sample
+
+	// Per harmonic state of the recursive oscillator bank
+	alignas(16) float gains    [NUM_HARMONICS];
+	alignas(16) float sines    [NUM_HARMONICS];
+	alignas(16) float cosines  [NUM_HARMONICS];
+	alignas(16) float rotate_sin[NUM_HARMONICS];
+	alignas(16) float rotate_cos[NUM_HARMONICS];
 	
 	for (int v = 0; v < voices.size(); v++) {
 		auto & voice = voices[v];
 
-		auto frequency = util::note_freq(voice.note);
+		auto frequency   = util::note_freq(voice.note);
+		auto phase_delta = frequency * SAMPLE_RATE_INV;
 
-		for (int i = voice.get_first_sample(synth.time); i < BLOCK_SIZE; i++) {
-			auto time_in_seconds = voice.sample * SAMPLE_RATE_INV;
-			auto time_in_steps   = time_in_seconds * steps_per_second;
-			
-			float amplitude;
-			auto done = voice.apply_envelope(time_in_steps, attack, hold, decay, sustain, release, amplitude);
-			
-			if (done) {
-				voices.erase(voices.begin() + v);
-				v--;
+		auto first = voice.get_first_sample(synth.time);
+		auto last  = voice.apply_envelope(envelope, samples_per_step, voice.sample, amplitudes, first);
 
-				break;
-			}
+		// Harmonics at or above Nyquist would alias, skip them
+		auto num_harmonics = std::min(NUM_HARMONICS, int(std::ceil(0.5f / phase_delta)) - 1);
+		auto num_groups    = (num_harmonics + simd::WIDTH - 1) / simd::WIDTH;
+
+		// Every harmonic is a phasor that gets rotated by a fixed angle each sample
+		// The phasors are recomputed from the wrapped phase every block, so rounding errors cannot accumulate
+		for (int h = 0; h < num_groups * simd::WIDTH; h++) {
+			auto harmonic = float(h + 1);
 
-			Sample sample = { };
+			auto angle       = TWO_PI * harmonic * voice.phase;
+			auto angle_delta = TWO_PI * harmonic * phase_delta;
 
-			auto harmonic_multiplier = 1.0f;
-			auto phase = TWO_PI * time_in_seconds * frequency;
+			gains     [h] = h < num_harmonics ? harmonics[h] : 0.0f;
+			sines     [h] = std::sin(angle);
+			cosines   [h] = std::cos(angle);
+			rotate_sin[h] = std::sin(angle_delta);
+			rotate_cos[h] = std::cos(angle_delta);
+		}
 
-			for (auto harmonic : harmonics) {
-				sample += harmonic * std::sin(harmonic_multiplier * phase);
+		std::fill(harmonic_sums + first, harmonic_sums + last, float4(0.0f));
 
-				harmonic_multiplier += 1.0f;
-			}
+		for (int g = 0; g < num_groups; g++) {
+			auto idx = g * simd::WIDTH;
 
-			outputs[0].get_sample(i) += amplitude * sample;
+			auto gain = float4::load(&gains  [idx]);
+			auto s    = float4::load(&sines  [idx]);
+			auto c    = float4::load(&cosines[idx]);
 
-			voice.sample += 1.0f;
+			auto rs = float4::load(&rotate_sin[idx]);
+			auto rc = float4::load(&rotate_cos[idx]);
+
+			for (int i = first; i < last; i++) {
+				harmonic_sums[i] += gain * s;
+
+				auto s_next = s * rc + c * rs;
+				auto c_next = c * rc - s * rs;
+
+				s = s_next;
+				c = c_next;
+			}
 		}
+
+		for (int i = first; i < last; i++) {
+			outputs[0].get_sample(i) += amplitudes[i] * simd::hsum(harmonic_sums[i]);
+		}
+
+		voice.sample += float(last - first);
+		voice.phase += float(last - first) * phase_delta;
+		voice.phase -= std::floor(voice.phase);
 	}
 }
 
@@ -93,6 +133,8 @@ void AdditiveSynthComponent::render(Synth const & synth) {
 	sustain.render(); ImGui::SameLine();
 	release.render();
 
+	render_voice_settings();
+
 	if (ImGui::Button("Saw")) {
 		for (int i = 0; i < NUM_HARMONICS; i++) {
 			harmonics[i] = 1.0f / (i + 1.0f);
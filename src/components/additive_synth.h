@@ -1,8 +1,11 @@
 #pragma once
 #include "voice.h"
 
+#include "util/simd.h"
+
 struct AdditiveVoice : Voice {
 	float sample = 0.0f;
+	float phase  = 0.0f; // Phase of the fundamental in cycles, wrapped to [0, 1)
 
 	AdditiveVoice(int note, float velocity, int start_time) : Voice(note, velocity, start_time) { }
 };
@@ -10,6 +13,8 @@ struct AdditiveVoice : Voice {
 struct AdditiveSynthComponent : VoiceComponent<AdditiveVoice> {
 	static constexpr auto NUM_HARMONICS = 32;
 
+	static_assert(NUM_HARMONICS % simd::WIDTH == 0);
+
 	float harmonics[NUM_HARMONICS] = { 1.0f };
 	
 	// Envelope
@@ -30,6 +30,9 @@ public:
 	virtual void update(struct Synth const & synth) = 0;
 	virtual void render(struct Synth const & synth) = 0;
 
+	// Components that load a file in the background are not ready (and output silence) until it has arrived
+	virtual bool is_ready() const { return true; }
+
 	void serialize(json::Writer & writer) const {
 		writer.write("id",     id);
 		writer.write("pos_x",  pos[0]);
@@ -3,6 +3,7 @@
 #include "arp.h"
 #include "bitcrusher.h"
 #include "compressor.h"
+#include "convolution.h"
 #include "decibel.h"
 #include "delay.h"
 #include "distortion.h"
@@ -14,6 +15,7 @@
 #include "improviser.h"
 #include "keyboard.h"
 #include "midi_player.h"
+#include "multiband_compressor.h"
 #include "oscillator.h"
 #include "oscilloscope.h"
 #include "pan.h"
@@ -26,6 +28,7 @@
 #include "split.h"
 #include "vectorscope.h"
 #include "vocoder.h"
+#include "wavetable.h"
 
 #include "util/meta.h"
 
@@ -40,6 +43,7 @@ using AllComponents = ComponentTypeList<
 	ArpComponent,
 	BitCrusherComponent,
 	CompressorComponent,
+	ConvolutionComponent,
 	DecibelComponent,
 	DelayComponent,
 	DistortionComponent,
@@ -47,6 +51,8 @@ using AllComponents = ComponentTypeList<
 	FilterComponent,
 	FlangerComponent,
 	FMComponent,
+	FM6Component,
+	FM8Component,
 	GainComponent,
 	ImproviserComponent,
 	KeyboardComponent,
@@ -56,11 +62,13 @@ using AllComponents = ComponentTypeList<
 	PhaserComponent,
 	ReverbComponent,
 	MIDIPlayerComponent,
+	MultibandCompressorComponent,
 	SamplerComponent,
 	SequencerComponent,
 	SpeakerComponent,
 	SpectrumComponent,
 	SplitComponent,
 	VectorscopeComponent,
-	VocoderComponent
+	VocoderComponent,
+	WavetableComponent
 >; // TypeList of all Components, used for deserialization. Synth::add_component<T> will only accept T that occur in this TypeList.
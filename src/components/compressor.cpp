@@ -1,40 +1,109 @@
 #include "compressor.h"
 
+#include "util/simd.h"
+
 // Based on: SimpleSource by ChunkWare Music Software
 // https://github.com/music-dsp-collection/chunkware-simple-dynamics
 
 void CompressorComponent::update(Synth const & synth) {
+	alignas(16) Sample input    [BLOCK_SIZE];
+	alignas(16) Sample sidechain[BLOCK_SIZE];
+
+	for (int i = 0; i < BLOCK_SIZE; i++) input[i] = inputs[0].get_sample(i);
+
+	// If there is no sidechain connected, use the input signal itself
+	auto const * source = input;
+
+	if (inputs[1].others.size() > 0) {
+		for (int i = 0; i < BLOCK_SIZE; i++) sidechain[i] = inputs[1].get_sample(i);
+		source = sidechain;
+	}
+
+	// Level of the sidechain per sample, converted to dB further down as (dB per octave) * log2(level)
+	alignas(16) float level[BLOCK_SIZE];
+	float db_per_octave;
+
+	if (detector == 0) {
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			level[i] = std::max(std::abs(source[i].left), std::abs(source[i].right));
+		}
+		db_per_octave = 20.0f * std::log10(2.0f);
+	} else {
+		// The mean square is a power, which needs half the dB scale of an amplitude (this saves a square root)
+		auto coef_rms = 1.0f - std::exp(-1000.0f / (RMS_WINDOW_IN_MS * SAMPLE_RATE));
+
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			power += coef_rms * (0.5f * (source[i].left * source[i].left + source[i].right * source[i].right) - power);
+			level[i] = power;
+		}
+		db_per_octave = 10.0f * std::log10(2.0f);
+	}
+
+	auto delay = int(0.001f * lookahead * SAMPLE_RATE);
+
+	if (delay > 0) {
+		for (int i = 0; i < BLOCK_SIZE; i++) level[i] = level_max.next(level[i], delay);
+	} else {
+		level_max.clear();
+	}
+
+	// Both the level and the gain conversions are done four samples at a time, only the envelope follower is serial
+	alignas(16) float exceeded_db[BLOCK_SIZE]; // How many dB are we over the threshold?
+
+	for (int i = 0; i < BLOCK_SIZE; i += simd::WIDTH) {
+		auto level_db = db_per_octave * simd::log2_fast(simd::float4::load(&level[i]));
+		simd::max(level_db - threshold, simd::float4(0.0f)).store(&exceeded_db[i]);
+	}
+
 	auto coef_attack  = std::exp(-1000.0f / (attack  * SAMPLE_RATE));
 	auto coef_release = std::exp(-1000.0f / (release * SAMPLE_RATE));
 
+	alignas(16) float env_db[BLOCK_SIZE];
+
 	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto sample    = inputs[0].get_sample(i);
-		auto sidechain = inputs[1].get_sample(i);
+		if (exceeded_db[i] >= env) {
+			env = exceeded_db[i] + coef_attack * (env - exceeded_db[i]);
+		} else {
+			env = exceeded_db[i] + coef_release * (env - exceeded_db[i]);
+		}
+		env_db[i] = env;
+	}
 
-		if (inputs[1].others.size() == 0) sidechain = sample; // If there is no sidechain connected, use the input signal itself
+	// 10^(dB / 20) = 2^(dB / (20 log10(2)))
+	auto slope          = simd::float4(1.0f / ratio - 1.0f);
+	auto octaves_per_db = 1.0f / (20.0f * std::log10(2.0f));
 
-		auto link    = std::max(std::abs(sidechain.left), std::abs(sidechain.right));
-		auto link_db = util::linear_to_db(link);
+	alignas(16) float gains[BLOCK_SIZE];
 
-		auto exceeded_db = std::max(link_db - threshold, 0.0f); // How many dB are we over the threshold?
+	for (int i = 0; i < BLOCK_SIZE; i += simd::WIDTH) {
+		auto gain_db = simd::float4::load(&env_db[i]) * slope + gain;
+		simd::exp2_fast(gain_db * octaves_per_db).store(&gains[i]);
+	}
 
-		if (exceeded_db >= env) {
-			env = exceeded_db + coef_attack * (env - exceeded_db);
-		} else {
-			env = exceeded_db + coef_release * (env - exceeded_db);
-		}
+	history.write(input, BLOCK_SIZE);
+
+	alignas(16) Sample delayed[BLOCK_SIZE];
+	if (delay > 0) history.read(BLOCK_SIZE + delay, delayed, BLOCK_SIZE);
 
-		sample = util::db_to_linear(env * (1.0f / ratio - 1.0f) + gain) * sample;
+	auto const * samples = delay > 0 ? delayed : input;
 
-		outputs[0].set_sample(i, sample);
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		outputs[0].set_sample(i, gains[i] * samples[i]);
 	}
 }
 
 void CompressorComponent::render(Synth const & synth) {
+	auto fmt_detector = [](int value, char * fmt, int len) {
+		strcpy_s(fmt, len, value == 0 ? "Peak" : "RMS");
+	};
+
 	threshold.render(); ImGui::SameLine();
 	ratio    .render(); ImGui::SameLine();
 	gain     .render();
 
 	attack .render(); ImGui::SameLine();
 	release.render();
+
+	detector .render(fmt_detector); ImGui::SameLine();
+	lookahead.render();
 }
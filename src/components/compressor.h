@@ -1,18 +1,34 @@
 #pragma once
 #include "component.h"
 
+#include "dsp/delay_line.h"
+#include "dsp/sliding_max.h"
+
 struct CompressorComponent : Component {
+	static constexpr auto MAX_LOOKAHEAD_IN_MS = 10.0f;
+	static constexpr auto RMS_WINDOW_IN_MS    = 10.0f;
+
 	Parameter<float> threshold = { this, "threshold", "Thrs", "Threshold (dB)", 0.0f, std::make_pair(-60.0f,   0.0f) };
 	Parameter<float> ratio     = { this, "ratio",     "Rat",  "Ratio",          1.0f, std::make_pair(  1.0f,  30.0f) };
 	Parameter<float> gain      = { this, "gain",      "Gain", "Gain (dB)",      0.0f, std::make_pair(-30.0f,  30.0f) };
 	Parameter<float> attack    = { this, "Attack",    "Att",  "Attack (ms)",   15.0f, std::make_pair(  0.0f, 400.0f) };
 	Parameter<float> release   = { this, "Release",   "Rel",  "Release (ms)", 200.0f, std::make_pair(  0.0f, 400.0f) };
 
+	Parameter<int>   detector  = { this, "detector",  "Det",  "Detector, Peak or RMS",                             0,    std::make_pair(0, 1) };
+	Parameter<float> lookahead = { this, "lookahead", "Look", "Lookahead (ms), delays the signal by the same time", 0.0f, std::make_pair(0.0f, MAX_LOOKAHEAD_IN_MS) };
+
 	CompressorComponent(int id) : Component(id, "Compressor", { { this, "Input" }, { this, "Sidechain" } }, { { this, "Out" } }) { }
 
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
 
 private:
-	float env = 0.0f;
+	static constexpr auto MAX_LOOKAHEAD = int(0.001f * MAX_LOOKAHEAD_IN_MS * SAMPLE_RATE) + 1; // In samples
+
+	float env   = 0.0f; // Gain reduction in dB
+	float power = 0.0f; // Mean square of the sidechain for the RMS detector
+
+	// The lookahead delays the input and takes the maximum level over the delay, so that the gain is reduced before a peak arrives
+	dsp::DelayLine<Sample> history = dsp::DelayLine<Sample>(BLOCK_SIZE + MAX_LOOKAHEAD);
+	dsp::SlidingMax        level_max = dsp::SlidingMax(MAX_LOOKAHEAD);
 };
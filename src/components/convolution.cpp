@@ -0,0 +1,89 @@
+#include "convolution.h"
+
+#include "synth/synth.h"
+#include "synth/sample_cache.h"
+
+#include "util/thread_pool.h"
+
+void ConvolutionComponent::load(char const * file) {
+	filename = file;
+
+	auto idx = filename.find_last_of("/\\");
+	filename_display = filename.c_str() + (idx == std::string::npos ? 0 : idx + 1);
+
+	convolver = nullptr;
+
+	convolver_loading = util::get_thread_pool().submit([file = filename]() -> std::unique_ptr<dsp::Convolver> {
+		// Goes through the same cache as the Sampler, so an impulse response that is also used as a sample is only loaded once
+		auto sample = sample_cache::load(file.c_str());
+		if (!sample) return nullptr;
+
+		std::vector<Sample> impulse_response(std::min(sample->length, dsp::Convolver::MAX_LENGTH));
+
+		if (sample->streamed) {
+			util::decode_wav_frames(sample->streamed->info, sample->streamed->file.data(), 0, int(impulse_response.size()), impulse_response.data());
+		} else {
+			sample->samples.decode(0, int(impulse_response.size()), impulse_response.data());
+		}
+
+		// Normalize to unit energy, so that noise passes through at roughly the same level regardless of the impulse response
+		auto energy = 0.0f;
+		for (auto const & sample : impulse_response) energy += 0.5f * (sample.left * sample.left + sample.right * sample.right);
+
+		if (energy > 0.0f) {
+			auto scale = 1.0f / std::sqrt(energy);
+			for (auto & sample : impulse_response) sample = scale * sample;
+		}
+
+		return std::make_unique<dsp::Convolver>(impulse_response);
+	});
+}
+
+void ConvolutionComponent::update(Synth const & synth) {
+	if (util::is_ready(convolver_loading)) convolver = convolver_loading.get();
+
+	auto linear_dry = util::db_to_linear(dry);
+	auto linear_wet = util::db_to_linear(wet);
+
+	Sample in [BLOCK_SIZE];
+	Sample out[BLOCK_SIZE] = { };
+
+	for (int i = 0; i < BLOCK_SIZE; i++) in[i] = inputs[0].get_sample(i);
+
+	if (convolver) convolver->process(in, out);
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		outputs[0].set_sample(i, linear_dry * in[i] + linear_wet * out[i]);
+	}
+}
+
+void ConvolutionComponent::render(Synth const & synth) {
+	if (convolver_loading.valid()) {
+		ImGui::Text("%s (Loading)", filename_display);
+	} else if (convolver) {
+		ImGui::Text("%s (%.2f s)", filename_display, float(convolver->get_length()) * SAMPLE_RATE_INV);
+	} else {
+		ImGui::Text("%s", filename_display);
+	}
+	ImGui::SameLine();
+
+	if (ImGui::Button("Load")) {
+		synth.file_dialog.show(FileDialog::Type::OPEN, "Open Impulse Response", "samples", ".wav", [this](char const * path) { load(path); });
+	}
+
+	dry.render(); ImGui::SameLine();
+	wet.render();
+}
+
+bool ConvolutionComponent::is_ready() const {
+	return !convolver_loading.valid() || util::is_ready(convolver_loading);
+}
+
+void ConvolutionComponent::serialize_custom(json::Writer & writer) const {
+	writer.write("filename", filename.c_str());
+}
+
+void ConvolutionComponent::deserialize_custom(json::Object const & object) {
+	auto file = object.find_string("filename", "");
+	if (file.size() > 0) load(file.c_str());
+}
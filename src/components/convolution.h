@@ -0,0 +1,33 @@
+#pragma once
+#include <future>
+
+#include "component.h"
+
+#include "dsp/convolver.h"
+
+// Convolves the input with an impulse response loaded from a WAV file (e.g. a recorded room, plate or speaker cabinet)
+struct ConvolutionComponent : Component {
+	std::string  filename;
+	char const * filename_display = "No Impulse Response";
+
+	Parameter<float> dry = { this, "dry", "Dry", "Dry Level (dB)",   0.0f, std::make_pair(-60.0f, 0.0f) };
+	Parameter<float> wet = { this, "wet", "Wet", "Wet Level (dB)", -12.0f, std::make_pair(-60.0f, 0.0f) };
+
+	ConvolutionComponent(int id) : Component(id, "Convolution", { { this, "In" } }, { { this, "Out" } }) { }
+
+	// The impulse response is loaded and transformed in the background, until then only the dry signal is output
+	void load(char const * file);
+
+	void update(struct Synth const & synth) override;
+	void render(struct Synth const & synth) override;
+
+	bool is_ready() const override;
+
+	void   serialize_custom(json::Writer & writer) const override;
+	void deserialize_custom(json::Object const & object) override;
+
+private:
+	std::unique_ptr<dsp::Convolver> convolver;
+
+	std::future<std::unique_ptr<dsp::Convolver>> convolver_loading; // Valid while the impulse response is being loaded
+};
@@ -1,23 +1,44 @@
 #include "decibel.h"
 
 void DecibelComponent::update(Synth const & synth) {
-	auto max_amplitude = 0.0f;
+	tap.push(inputs[0]);
+}
 
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto sample = inputs[0].get_sample(i);
-		auto amplitude = std::max(std::abs(sample.left), std::abs(sample.right));
+void DecibelComponent::analyse() {
+	auto position = tap.get_position();
 
-		max_amplitude = std::max(max_amplitude, amplitude);
-	}
+	while (read_position + BLOCK_SIZE <= position) {
+		Sample block[BLOCK_SIZE];
+
+		// If the meter was hidden for a while the blocks in between have been overwritten, start the history over from the latest block
+		if (!tap.read(read_position, BLOCK_SIZE, block)) {
+			history.clear();
+			history_index = 0;
+
+			position      = tap.get_position();
+			read_position = position - BLOCK_SIZE;
+			continue;
+		}
+
+		read_position += BLOCK_SIZE;
 
-	decibels = util::linear_to_db(max_amplitude);
-	if (decibels < -60.0f) decibels = -INFINITY;
+		auto max_amplitude = 0.0f;
 
-	if (history.size() < HISTORY_LENGTH) {
-		history.push_back(max_amplitude);
-	} else {
-		history[history_index] = max_amplitude;
-		history_index = util::wrap(history_index + 1, HISTORY_LENGTH);
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			auto amplitude = std::max(std::abs(block[i].left), std::abs(block[i].right));
+
+			max_amplitude = std::max(max_amplitude, amplitude);
+		}
+
+		decibels = util::linear_to_db(max_amplitude);
+		if (decibels < -60.0f) decibels = -INFINITY;
+
+		if (history.size() < HISTORY_LENGTH) {
+			history.push_back(max_amplitude);
+		} else {
+			history[history_index] = max_amplitude;
+			history_index = util::wrap(history_index + 1, HISTORY_LENGTH);
+		}
 	}
 }
 
@@ -30,6 +51,9 @@ void DecibelComponent::render(Synth const & synth) {
 	auto const colour_bad        = ImColor(250,  50,  50, 255);
 	auto const colour_white      = ImColor(250, 250, 250, 255);
 
+	// Only analyse when on screen, render() itself is only called when the window is not collapsed
+	if (ImGui::IsRectVisible(ImGui::GetContentRegionAvail())) analyse();
+
 	auto colour_foreground = decibels < 0.0f ? colour_good : colour_bad;
 
 	static constexpr auto DB_MIN = -60.0f;
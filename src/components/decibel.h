@@ -1,6 +1,8 @@
 #pragma once
 #include "component.h"
 
+#include "synth/tap.h"
+
 struct DecibelComponent : Component {
 	float decibels = -INFINITY;
 
@@ -13,8 +15,14 @@ private:
 	static constexpr auto HISTORY_LENGTH_IN_SECONDS = 1.5f;
 	static constexpr auto HISTORY_LENGTH            = int(HISTORY_LENGTH_IN_SECONDS * SAMPLE_RATE / BLOCK_SIZE);
 
-	std::vector<float> history;
+	Tap<16 * BLOCK_SIZE> tap;
+
+	int64_t read_position = 0; // Tap position up to which blocks have been added to the history
+
+	std::vector<float> history; // Peak amplitude per block
 	int                history_index = 0;
 
 	float previous_height_factor = 0.0f;
+
+	void analyse();
 };
@@ -2,27 +2,25 @@
 
 #include "synth/synth.h"
 
-void DelayComponent::history_resize(int size) {
-	history.resize(size);
-	offset %= history.size();
-}
-
 void DelayComponent::update(Synth const & synth) {
-	auto history_size = size_t(60) * SAMPLE_RATE * steps / (4 * synth.settings.tempo);
-	
-	if (history.size() != history_size) {
-		history_resize(history_size);
-	}
+	auto delay = std::min(60 * SAMPLE_RATE * steps / (4 * synth.settings.tempo), MAX_DELAY);
+
+	Sample delayed[BLOCK_SIZE];
+	Sample samples[BLOCK_SIZE];
+
+	// Every chunk only reads samples that were written before the chunk, so it can be read and written as a whole
+	for (int chunk_start = 0; chunk_start < BLOCK_SIZE; chunk_start += delay) {
+		auto chunk_size = std::min(delay, BLOCK_SIZE - chunk_start);
+
+		history.read(delay, delayed, chunk_size);
 
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto sample = inputs[0].get_sample(i);
+		for (int i = 0; i < chunk_size; i++) {
+			samples[i] = inputs[0].get_sample(chunk_start + i) + feedback * delayed[i];
 
-		sample = sample + feedback * history[offset];
-		history[offset] = sample;
-	
-		offset = util::wrap(offset + 1, int(history.size()));
+			outputs[0].set_sample(chunk_start + i, samples[i]);
+		}
 
-		outputs[0].set_sample(i, sample);
+		history.write(samples, chunk_size);
 	}
 }
 
@@ -1,16 +1,20 @@
 #pragma once
 #include "component.h"
 
+#include "dsp/delay_line.h"
+
 struct DelayComponent : Component {
-	Parameter<int>   steps    = { this, "steps",    "Del", "Delay in Steps",  3,    std::make_pair(1, 8) };
+	static constexpr auto MAX_STEPS = 8;
+	static constexpr auto MIN_TEMPO = 60;
+
+	static constexpr auto MAX_DELAY = 60 * SAMPLE_RATE * MAX_STEPS / (4 * MIN_TEMPO); // In samples, at the lowest tempo
+
+	Parameter<int>   steps    = { this, "steps",    "Del", "Delay in Steps",  3,    std::make_pair(1, MAX_STEPS) };
 	Parameter<float> feedback = { this, "feedback", "FB",  "Feedback Amount", 0.7f, std::make_pair(0.0f, 1.0f) };
 
-	std::vector<Sample> history;
-	int offset = 0;
+	dsp::DelayLine<Sample> history = dsp::DelayLine<Sample>(MAX_DELAY);
 
 	DelayComponent(int id) : Component(id, "Delay", { { this, "In" } }, { { this, "Out" } }) { }
-
-	void history_resize(int size);
 	
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
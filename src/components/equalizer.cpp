@@ -2,33 +2,83 @@
 
 #include <ImGui/implot.h>
 
+void EqualizerComponent::add_band(float freq, float gain) {
+	if (bands.size() >= MAX_BANDS) return;
+
+	auto & band = bands.emplace_back(freq);
+	band.gain = gain;
+}
+
+void EqualizerComponent::remove_band(int index) {
+	if (bands[index].in_cascade) {
+		auto section = 0;
+		for (int b = 0; b < index; b++) {
+			if (bands[b].in_cascade) section++;
+		}
+
+		cascade.remove_section(section);
+	}
+
+	bands.erase(bands.begin() + index);
+}
+
 void EqualizerComponent::update(Synth const & synth) {
+	auto section = 0;
+
 	for (auto & band : bands) {
-		dsp::BiQuadFilterMode mode;
-		switch (band.mode) {
-			case 0: mode = dsp::BiQuadFilterMode::LOW_PASS;   break;
-			case 1: mode = dsp::BiQuadFilterMode::BAND_PASS;  break;
-			case 2: mode = dsp::BiQuadFilterMode::HIGH_PASS;  break;
-			case 3: mode = dsp::BiQuadFilterMode::PEAK;       break;
-			case 4: mode = dsp::BiQuadFilterMode::NOTCH;      break;
-			case 5: mode = dsp::BiQuadFilterMode::LOW_SHELF;  break;
-			case 6: mode = dsp::BiQuadFilterMode::HIGH_SHELF; break;
-
-			default: abort();
+		auto changed =
+			band.mode != band.applied_mode ||
+			band.freq != band.applied_freq ||
+			band.Q    != band.applied_Q    ||
+			band.gain != band.applied_gain;
+
+		if (changed) {
+			dsp::BiQuadFilterMode mode;
+			switch (band.mode) {
+				case 0: mode = dsp::BiQuadFilterMode::LOW_PASS;   break;
+				case 1: mode = dsp::BiQuadFilterMode::BAND_PASS;  break;
+				case 2: mode = dsp::BiQuadFilterMode::HIGH_PASS;  break;
+				case 3: mode = dsp::BiQuadFilterMode::PEAK;       break;
+				case 4: mode = dsp::BiQuadFilterMode::NOTCH;      break;
+				case 5: mode = dsp::BiQuadFilterMode::LOW_SHELF;  break;
+				case 6: mode = dsp::BiQuadFilterMode::HIGH_SHELF; break;
+
+				default: abort();
+			}
+
+			band.coefficients = dsp::BiQuadCoefficients::design(mode, band.freq, band.Q, band.gain);
+
+			band.applied_mode = band.mode;
+			band.applied_freq = band.freq;
+			band.applied_Q    = band.Q;
+			band.applied_gain = band.gain;
 		}
 
-		band.filter.set(mode, band.freq, band.Q, band.gain);	
+		// Bands that become flat leave the cascade, bands that stop being flat are inserted with a fresh state
+		auto flat = band.is_flat();
+
+		if (flat && band.in_cascade) {
+			cascade.remove_section(section);
+			band.in_cascade = false;
+		} else if (!flat && !band.in_cascade) {
+			cascade.insert_section(section);
+			cascade.set_section(section, band.coefficients);
+			band.in_cascade = true;
+		} else if (!flat && changed) {
+			cascade.set_section(section, band.coefficients);
+		}
+
+		if (band.in_cascade) section++;
 	}
-	
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto sample = inputs[0].get_sample(i);
 
-		for (auto & band : bands) {
-			sample = band.filter.process(sample);
-		}
+	Sample samples[BLOCK_SIZE];
+	for (int i = 0; i < BLOCK_SIZE; i++) samples[i] = inputs[0].get_sample(i);
 
-		outputs[0].set_sample(i, sample);
+	if (cascade.get_num_sections() > 0) {
+		cascade.process(samples, samples);
 	}
+
+	for (int i = 0; i < BLOCK_SIZE; i++) outputs[0].set_sample(i, samples[i]);
 }
 
 void EqualizerComponent::render(Synth const & synth) {
@@ -65,10 +115,10 @@ void EqualizerComponent::render(Synth const & synth) {
 
 			auto response = 0.0f;
 
-			for (int b = 0; b < NUM_BANDS; b++) {
-				auto const & band = reinterpret_cast<Band const *>(data)[b];
+			for (auto const & band : reinterpret_cast<EqualizerComponent const *>(data)->bands) {
+				if (band.is_flat()) continue;
 
-				auto b0 = band.filter.b0, b1 = band.filter.b1, b2 = band.filter.b2, a1 = band.filter.a1, a2 = band.filter.a2;
+				auto b0 = band.coefficients.b0, b1 = band.coefficients.b1, b2 = band.coefficients.b2, a1 = band.coefficients.a1, a2 = band.coefficients.a2;
 
 				// Single precision is sufficient, using the trick described here: https://dsp.stackexchange.com/a/16911
 				auto b012 = 0.5f * (b0   + b1 + b2);
@@ -83,12 +133,15 @@ void EqualizerComponent::render(Synth const & synth) {
 			return { freq, response };
 		};
 
-		ImPlot::PlotLineG("", getter, bands, N);
+		ImPlot::PlotLineG("", getter, this, N);
 
 		char label[32] = { };
 		char popup_label[32] = { };
 
-		for (int b = 0; b < NUM_BANDS; b++) {
+		auto band_hovered = false;
+		auto band_removed = -1;
+
+		for (int b = 0; b < bands.size(); b++) {
 			auto & band = bands[b];
 
 			sprintf_s(label, "#%i", b);
@@ -103,6 +156,8 @@ void EqualizerComponent::render(Synth const & synth) {
 			band.gain = g;
 
 			if (ImGui::IsItemHovered()) {
+				band_hovered = true;
+
 				band.Q = util::clamp(band.Q - 0.1f * ImGui::GetIO().MouseWheel, 0.0f, Band::MAX_Q);
 
 				if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
@@ -125,22 +180,35 @@ void EqualizerComponent::render(Synth const & synth) {
 				ImGui::Text("Q:    %.1f", band.Q);
 				ImGui::Text("gain: %.1f", band.gain);
 
+				if (ImGui::Button("Remove")) {
+					band_removed = b;
+					ImGui::CloseCurrentPopup();
+				}
+
 				ImGui::EndPopup();
 			}
 
 			ImPlot::PlotText(label, f, g, false, ImVec2(0, -12));
 		}
 
+		if (band_removed != -1) remove_band(band_removed);
+
+		// Double clicking on an empty spot adds a band there
+		if (ImPlot::IsPlotHovered() && !band_hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+			auto mouse = ImPlot::GetPlotMousePos();
+			add_band(mouse.x, mouse.y);
+		}
+
 		ImPlot::EndPlot();
 	}
 }
 
 void EqualizerComponent::serialize_custom(json::Writer & writer) const {
-	writer.write("NUM_BANDS", NUM_BANDS);
+	writer.write("NUM_BANDS", int(bands.size()));
 
 	char label[32] = { };
 
-	for (int i = 0; i < NUM_BANDS; i++) {
+	for (int i = 0; i < bands.size(); i++) {
 		auto const & band = bands[i];
 
 		sprintf_s(label, "Band_%i", i);
@@ -158,27 +226,27 @@ void EqualizerComponent::serialize_custom(json::Writer & writer) const {
 void EqualizerComponent::deserialize_custom(json::Object const & object) {
 	auto num_bands = object.find_int("NUM_BANDS");
 
-	if (num_bands != NUM_BANDS) {
-		printf("WARNING: NUM_BANDS of Equalizer did not match!\n");
-		__debugbreak();
+	if (num_bands > MAX_BANDS) {
+		printf("WARNING: Equalizer has more than %i bands, the remaining bands are ignored!\n", MAX_BANDS);
+		num_bands = MAX_BANDS;
 	}
 
+	bands.clear();
+	cascade = { };
+
 	char label[32] = { };
 
-	for (int i = 0; i < NUM_BANDS; i++) {
+	for (int i = 0; i < num_bands; i++) {
 		sprintf_s(label, "Band_%i", i);
 		auto band_obj = object.find<json::Object const>(label);
 
-		if (band_obj == nullptr) {
-			bands[i].mode = 3;
-			bands[i].freq = 1000.0f;
-			bands[i].Q    = 1.0f;
-			bands[i].gain = 0.0f;
-		} else {
-			bands[i].mode = band_obj->find_int  ("mode", 3);
-			bands[i].freq = band_obj->find_float("freq", 1000.0f);
-			bands[i].Q    = band_obj->find_float("Q",    1.0f);
-			bands[i].gain = band_obj->find_float("gain", 0.0f);
+		auto & band = bands.emplace_back(1000.0f);
+
+		if (band_obj) {
+			band.mode = band_obj->find_int  ("mode", 3);
+			band.freq = band_obj->find_float("freq", 1000.0f);
+			band.Q    = band_obj->find_float("Q",    1.0f);
+			band.gain = band_obj->find_float("gain", 0.0f);
 		}
 	}
 }
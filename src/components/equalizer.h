@@ -2,9 +2,10 @@
 #include "component.h"
 
 #include "dsp/biquadfilter.h"
+#include "dsp/biquad_cascade.h"
 
 struct EqualizerComponent : Component {
-	static constexpr auto NUM_BANDS = 4;
+	static constexpr auto MAX_BANDS = dsp::BiQuadCascade::MAX_SECTIONS;
 
 	struct Band {
 		static constexpr auto MAX_Q = 10.0f;
@@ -24,15 +25,30 @@ struct EqualizerComponent : Component {
 		float Q    = 1.0f;
 		float gain = 0.0f;
 
-		dsp::BiQuadFilter<Sample> filter;
+		// Parameters the coefficients were last designed for, coefficients are only redesigned when these change
+		int   applied_mode = -1;
+		float applied_freq = 0.0f;
+		float applied_Q    = 0.0f;
+		float applied_gain = 0.0f;
+
+		dsp::BiQuadCoefficients coefficients;
+
+		bool in_cascade = false; // Flat bands pass their input through unchanged and are left out of the cascade
 
 		Band(float freq) : freq(freq) { }
+
+		bool is_flat() const { return (mode == 3 || mode == 5 || mode == 6) && gain == 0.0f; } // Peak and shelves with zero gain
 	};
 
-	Band bands[NUM_BANDS] = { 63.0f, 294.0f, 1363.0f, 6324.0f };
+	std::vector<Band> bands = { 63.0f, 294.0f, 1363.0f, 6324.0f };
+
+	dsp::BiQuadCascade cascade; // One section per band that is not flat, in the same order as the bands
 
 	EqualizerComponent(int id) : Component(id, "Equalizer", { { this, "In" } }, { { this, "Out" } }) { }
 
+	void add_band   (float freq, float gain);
+	void remove_band(int index);
+
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
 
@@ -13,22 +13,18 @@ void FlangerComponent::update(Synth const & synth) {
 
 		lfo_phase += rate * SAMPLE_RATE_INV;
 
-		auto index_left  = float(history_offset) - lfo_left  * SAMPLE_RATE;
-		auto index_right = float(history_offset) - lfo_right * SAMPLE_RATE;
+		// A delay of less than one sample would read the sample that is about to be written
+		auto delay_left  = std::max(lfo_left  * SAMPLE_RATE, 1.0f);
+		auto delay_right = std::max(lfo_right * SAMPLE_RATE, 1.0f);
 
 		auto delayed_sample = Sample(
-			util::sample_linear(history_left,  HISTORY_SIZE, index_left),
-			util::sample_linear(history_right, HISTORY_SIZE, index_right)
+			history.read_linear(delay_left) .left,
+			history.read_linear(delay_right).right
 		);
 
 		outputs[0].set_sample(i, util::lerp(sample, delayed_sample, drywet));
 		
-		auto fb = sample + delayed_sample * feedback;
-
-		history_left [history_offset] = fb.left;
-		history_right[history_offset] = fb.right;
-
-		history_offset = util::wrap(history_offset + 1, HISTORY_SIZE);
+		history.write(sample + delayed_sample * feedback);
 	}
 }
 
@@ -1,9 +1,14 @@
 #pragma once
 #include "component.h"
 
+#include "dsp/delay_line.h"
+
 struct FlangerComponent : Component {
-	Parameter<float> delay    = { this, "delay",    "Del",  "Delay",                               0.5f,  std::make_pair(0.001f, 10.0f) };
-	Parameter<float> depth    = { this, "depth",    "Dep",  "Depth",                               0.5f,  std::make_pair(0.001f, 10.0f) };
+	static constexpr auto MAX_DELAY_IN_MS = 10.0f;
+	static constexpr auto MAX_DEPTH_IN_MS = 10.0f;
+
+	Parameter<float> delay    = { this, "delay",    "Del",  "Delay",                               0.5f,  std::make_pair(0.001f, MAX_DELAY_IN_MS) };
+	Parameter<float> depth    = { this, "depth",    "Dep",  "Depth",                               0.5f,  std::make_pair(0.001f, MAX_DEPTH_IN_MS) };
 	Parameter<float> rate     = { this, "rate",     "Rate", "LFO Frequency",                       1.0f,  std::make_pair(0.0f,    5.0f) };
 	Parameter<float> phase    = { this, "phase",    "Phs",  "Phase Offset between Left and Right", 0.02f, std::make_pair(0.0f,    1.0f), { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f } };
 	Parameter<float> feedback = { this, "feedback", "FB",   "Feedback Amount",                     0.2f,  std::make_pair(0.0f,    1.0f) };
@@ -15,12 +20,9 @@ struct FlangerComponent : Component {
 	void render(struct Synth const & synth) override;
 
 private:
-	static constexpr auto MAX_DELAY_IN_SECONDS = 1;
-	static constexpr auto HISTORY_SIZE = MAX_DELAY_IN_SECONDS * SAMPLE_RATE;
+	static constexpr auto MAX_DELAY = int(0.001f * (MAX_DELAY_IN_MS + MAX_DEPTH_IN_MS) * SAMPLE_RATE) + 1; // In samples
 
-	float history_left [HISTORY_SIZE] = { };
-	float history_right[HISTORY_SIZE] = { };
-	int   history_offset = 0;
+	dsp::DelayLine<Sample> history = dsp::DelayLine<Sample>(MAX_DELAY);
 
 	float lfo_phase = 0.0f;
 };
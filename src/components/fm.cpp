@@ -2,70 +2,153 @@
 
 #include "synth/synth.h"
 
-void FMComponent::update(Synth const & synth) {
+using simd::float4;
+
+template<int NUM_OPERATORS>
+void FMComponentBase<NUM_OPERATORS>::update(Synth const & synth) {
 	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
 
-	update_voices(steps_per_second);
-
-	for (int v = 0; v < voices.size(); v++) {
-		auto & voice = voices[v];
-
-		auto carrier_freq = util::note_freq(voice.note);
-		
-		for (int i = voice.get_first_sample(synth.time); i < BLOCK_SIZE; i++) {
-			auto time_in_seconds = voice.sample * SAMPLE_RATE_INV;
-			auto time_in_steps   = time_in_seconds * steps_per_second;
-			
-			float amplitude;
-			auto done = voice.apply_envelope(time_in_steps, 0.0f, INFINITY, 0.0f, 1.0f, release, amplitude);
-			
-			if (done) {
-				voices.erase(voices.begin() + v);
-				v--;
-
-				break;
-			}
+	this->update_voices(steps_per_second);
 
-			Sample sample = { };
+	for (int v = 0; v < this->voices.size(); v += simd::WIDTH) {
+		render_voices(synth, v, std::min(simd::WIDTH, int(this->voices.size()) - v));
+	}
+}
 
-			float next_operator_values[FM_NUM_OPERATORS] = { };
+// Renders up to simd::WIDTH Voices starting at first_voice, with one Voice per SIMD lane
+template<int NUM_OPERATORS>
+void FMComponentBase<NUM_OPERATORS>::render_voices(Synth const & synth, int first_voice, int num_voices) {
+	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+	auto samples_per_step = SAMPLE_RATE / steps_per_second;
 
-			auto phase = TWO_PI * time_in_seconds * carrier_freq; 
+	auto envelope = dsp::Envelope::from_steps(0.0f, INFINITY, 0.0f, 1.0f, release, samples_per_step);
 
-			for (int o = 0; o < FM_NUM_OPERATORS; o++) {
-				auto phs = ratios[o] * phase;
+	dsp::Envelope envelope_operators[NUM_OPERATORS];
+	for (int o = 0; o < NUM_OPERATORS; o++) {
+		envelope_operators[o] = dsp::Envelope::from_steps(attacks[o], holds[o], decays[o], sustains[o], 0.0f, samples_per_step);
+	}
 
-				// Modulate phase of operator o using the values of other operators p
-				for (int p = 0; p < FM_NUM_OPERATORS; p++) {
-					phs += weights[p][o] * voice.operator_values[p];
-				}
+	// Per sample envelopes, interleaved by lane
+	alignas(16) float amplitudes         [BLOCK_SIZE * simd::WIDTH];
+	alignas(16) float operator_amplitudes[NUM_OPERATORS][BLOCK_SIZE * simd::WIDTH];
+
+	// Per Voice state, transposed so that every operator holds one Voice per lane
+	alignas(16) float phases      [NUM_OPERATORS][simd::WIDTH] = { };
+	alignas(16) float phase_deltas[NUM_OPERATORS][simd::WIDTH] = { };
+	alignas(16) float values      [NUM_OPERATORS][simd::WIDTH] = { };
+
+	auto clear = [](float * lane, int from, int to) {
+		for (int i = from; i < to; i++) lane[i * simd::WIDTH] = 0.0f;
+	};
+
+	for (int lane = 0; lane < simd::WIDTH; lane++) {
+		if (lane >= num_voices) {
+			clear(amplitudes + lane, 0, BLOCK_SIZE);
+			for (int o = 0; o < NUM_OPERATORS; o++) clear(operator_amplitudes[o] + lane, 0, BLOCK_SIZE);
+
+			continue;
+		}
 
-				auto value = util::envelope(time_in_steps, attacks[o], holds[o], decays[o], sustains[o]) * std::sin(phs);
-				next_operator_values[o] = value;
+		auto & voice = this->voices[first_voice + lane];
 
-				sample += outs[o] * value;
+		auto carrier_delta = util::note_freq(voice.note) * SAMPLE_RATE_INV;
+
+		auto first = voice.get_first_sample(synth.time);
+		auto last  = voice.apply_envelope(envelope, samples_per_step, voice.sample, amplitudes + lane, first, 1.0f, simd::WIDTH);
+
+		clear(amplitudes + lane, 0,    first);
+		clear(amplitudes + lane, last, BLOCK_SIZE);
+
+		for (int o = 0; o < NUM_OPERATORS; o++) {
+			envelope_operators[o].fill(operator_amplitudes[o] + lane, first, last, voice.sample, 1.0f, INFINITY, 1.0f, simd::WIDTH);
+
+			// Operators stay silent before the Voice starts, so no modulation leaks into its first sample
+			clear(operator_amplitudes[o] + lane, 0,    first);
+			clear(operator_amplitudes[o] + lane, last, BLOCK_SIZE);
+
+			phase_deltas[o][lane] = ratios[o] * carrier_delta;
+
+			// The phases advance every sample of the block, offset them so that a Voice starting in this block is at phase zero on its first sample
+			if (voice.sample == 0.0f) voice.operator_phases[o] = -float(first) * phase_deltas[o][lane];
+
+			phases[o][lane] = voice.operator_phases[o];
+			values[o][lane] = voice.operator_values[o];
+		}
+
+		voice.sample += float(last - first);
+	}
+
+	float4 phase[NUM_OPERATORS];
+	float4 delta[NUM_OPERATORS];
+	float4 value[NUM_OPERATORS];
+
+	for (int o = 0; o < NUM_OPERATORS; o++) {
+		phase[o] = float4::load(phases      [o]);
+		delta[o] = float4::load(phase_deltas[o]);
+		value[o] = float4::load(values      [o]);
+	}
+
+	// Weights are in radians, convert to cycles
+	float modulation_weights[NUM_OPERATORS][NUM_OPERATORS];
+	for (int p = 0; p < NUM_OPERATORS; p++) {
+		for (int o = 0; o < NUM_OPERATORS; o++) modulation_weights[p][o] = weights[p][o] / TWO_PI;
+	}
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		auto idx = i * simd::WIDTH;
+
+		float4 sample;
+		float4 next_value[NUM_OPERATORS];
+
+		for (int o = 0; o < NUM_OPERATORS; o++) {
+			auto phs = phase[o];
+
+			// Modulate phase of operator o using the values of other operators p
+			for (int p = 0; p < NUM_OPERATORS; p++) {
+				phs += modulation_weights[p][o] * value[p];
 			}
 
-			std::memcpy(voice.operator_values, next_operator_values, sizeof(voice.operator_values));
+			next_value[o] = float4::load(&operator_amplitudes[o][idx]) * simd::sin_turns(phs);
+
+			sample += outs[o] * next_value[o];
 
-			outputs[0].get_sample(i) += amplitude * sample;
+			phase[o] = simd::frac(phase[o] + delta[o]);
+		}
+
+		for (int o = 0; o < NUM_OPERATORS; o++) value[o] = next_value[o];
+
+		sample *= float4::load(&amplitudes[idx]);
+
+		this->outputs[0].get_sample(i) += simd::hsum(sample);
+	}
 
-			voice.sample += 1.0f;
+	for (int o = 0; o < NUM_OPERATORS; o++) {
+		phase[o].store(phases[o]);
+		value[o].store(values[o]);
+	}
+
+	for (int lane = 0; lane < num_voices; lane++) {
+		auto & voice = this->voices[first_voice + lane];
+
+		for (int o = 0; o < NUM_OPERATORS; o++) {
+			voice.operator_phases[o] = phases[o][lane];
+			voice.operator_values[o] = values[o][lane];
 		}
 	}
 }
 
-void FMComponent::render(Synth const & synth) {
+template<int NUM_OPERATORS>
+void FMComponentBase<NUM_OPERATORS>::render(Synth const & synth) {
 	char label[128] = { };
 
 	ImVec2 cur = { };
 
-	for (int op_to = 0; op_to < FM_NUM_OPERATORS; op_to++) {
-		for (int op_from = 0; op_from < FM_NUM_OPERATORS; op_from++) {
+	for (int op_to = 0; op_to < NUM_OPERATORS; op_to++) {
+		for (int op_from = 0; op_from < NUM_OPERATORS; op_from++) {
 			sprintf_s(label, "Operator %i to %i", op_from, op_to);
 			ImGui::Knob(label, "", label, &weights[op_from][op_to], 0.0f, 2.0f, false, "", 12.0f);
 
-			auto spacing = op_from < FM_NUM_OPERATORS - 1 ? -1.0f : 12.0f;
+			auto spacing = op_from < NUM_OPERATORS - 1 ? -1.0f : 12.0f;
 			ImGui::SameLine(0.0f, spacing);
 		}
 
@@ -88,7 +171,7 @@ void FMComponent::render(Synth const & synth) {
 	ImGui::SetCursorPos(prev);
 
 	if (ImGui::BeginTabBar("Operators")) {
-		for (int i = 0; i < FM_NUM_OPERATORS; i++) {
+		for (int i = 0; i < NUM_OPERATORS; i++) {
 			sprintf_s(label, "Op %i", i);
 
 			if (ImGui::BeginTabItem(label)) {
@@ -105,14 +188,22 @@ void FMComponent::render(Synth const & synth) {
 
 		ImGui::EndTabBar();
 	}
+
+	this->render_voice_settings();
 }
 
-void FMComponent::serialize_custom(json::Writer & writer) const {
-	writer.write("weights", FM_NUM_OPERATORS * FM_NUM_OPERATORS, &weights[0][0]);
-	writer.write("outs",    FM_NUM_OPERATORS, outs);
+template<int NUM_OPERATORS>
+void FMComponentBase<NUM_OPERATORS>::serialize_custom(json::Writer & writer) const {
+	writer.write("weights", NUM_OPERATORS * NUM_OPERATORS, &weights[0][0]);
+	writer.write("outs",    NUM_OPERATORS, outs);
 }
 
-void FMComponent::deserialize_custom(json::Object const & object) {
-	object.find_array("weights", FM_NUM_OPERATORS * FM_NUM_OPERATORS, &weights[0][0]);
-	object.find_array("outs",    FM_NUM_OPERATORS, outs);
+template<int NUM_OPERATORS>
+void FMComponentBase<NUM_OPERATORS>::deserialize_custom(json::Object const & object) {
+	object.find_array("weights", NUM_OPERATORS * NUM_OPERATORS, &weights[0][0]);
+	object.find_array("outs",    NUM_OPERATORS, outs);
 }
+
+template struct FMComponentBase<4>;
+template struct FMComponentBase<6>;
+template struct FMComponentBase<8>;
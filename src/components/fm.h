@@ -1,59 +1,73 @@
 #pragma once
+#include <array>
+
 #include "voice.h"
 
-static constexpr auto FM_NUM_OPERATORS = 4;
+#include "util/simd.h"
 
+template<int NUM_OPERATORS>
 struct FMVoice : Voice {
 	float sample = 0.0f;
 
-	float operator_values[FM_NUM_OPERATORS] = { };
+	float operator_phases[NUM_OPERATORS] = { }; // In cycles, wrapped to [0, 1)
+	float operator_values[NUM_OPERATORS] = { };
 
 	FMVoice(int note, float velocity, int start_time) : Voice(note, velocity, start_time) { }
 };
 
-struct FMComponent : VoiceComponent<FMVoice> {
-	float weights[FM_NUM_OPERATORS][FM_NUM_OPERATORS] = { };
-	float outs[FM_NUM_OPERATORS] = { 1.0f };
-
-	Parameter<float> ratios[FM_NUM_OPERATORS] = {
-		{ this, "ratio_0", "Rat", "Ratio", 1.0f, std::make_pair(0.25f, 16.0f), { 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f } },
-		{ this, "ratio_1", "Rat", "Ratio", 2.0f, std::make_pair(0.25f, 16.0f), { 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f } },
-		{ this, "ratio_2", "Rat", "Ratio", 4.0f, std::make_pair(0.25f, 16.0f), { 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f } },
-		{ this, "ratio_3", "Rat", "Ratio", 8.0f, std::make_pair(0.25f, 16.0f), { 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f } }
-	};
-	
-	Parameter<float> attacks[FM_NUM_OPERATORS] = {
-		Parameter<float>::make_attack(this, "attack_0"),
-		Parameter<float>::make_attack(this, "attack_1"),
-		Parameter<float>::make_attack(this, "attack_2"),
-		Parameter<float>::make_attack(this, "attack_3")
-	};
-	Parameter<float> holds[FM_NUM_OPERATORS] = {
-		Parameter<float>::make_hold(this, "hold_0"),
-		Parameter<float>::make_hold(this, "hold_1"),
-		Parameter<float>::make_hold(this, "hold_2"),
-		Parameter<float>::make_hold(this, "hold_3")
-	};
-	Parameter<float> decays[FM_NUM_OPERATORS] = {
-		Parameter<float>::make_decay(this, "decay_0"),
-		Parameter<float>::make_decay(this, "decay_1"),
-		Parameter<float>::make_decay(this, "decay_2"),
-		Parameter<float>::make_decay(this, "decay_3")
-	};
-	Parameter<float> sustains[FM_NUM_OPERATORS] = {
-		Parameter<float>::make_sustain(this, "sustain_0"),
-		Parameter<float>::make_sustain(this, "sustain_1"),
-		Parameter<float>::make_sustain(this, "sustain_2"),
-		Parameter<float>::make_sustain(this, "sustain_3")
-	};
+// FM synth with a compile time number of operators, every operator can modulate the phase of every operator
+template<int NUM_OPERATORS>
+struct FMComponentBase : VoiceComponent<FMVoice<NUM_OPERATORS>> {
+	static constexpr auto MAX_OPERATORS = 8;
+	static_assert(NUM_OPERATORS <= MAX_OPERATORS);
+
+	float weights[NUM_OPERATORS][NUM_OPERATORS] = { };
+	float outs[NUM_OPERATORS] = { 1.0f };
+
+	std::array<Parameter<float>, NUM_OPERATORS> ratios   = make_operator_parameters([this](int o) { return Parameter<float>(this, ratio_names[o], "Rat", "Ratio", ratio_defaults[o], std::make_pair(0.25f, 16.0f), { 0.25f, 0.5f, 0.75f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f }); });
+	std::array<Parameter<float>, NUM_OPERATORS> attacks  = make_operator_parameters([this](int o) { return Parameter<float>::make_attack (this, attack_names [o]); });
+	std::array<Parameter<float>, NUM_OPERATORS> holds    = make_operator_parameters([this](int o) { return Parameter<float>::make_hold   (this, hold_names   [o]); });
+	std::array<Parameter<float>, NUM_OPERATORS> decays   = make_operator_parameters([this](int o) { return Parameter<float>::make_decay  (this, decay_names  [o]); });
+	std::array<Parameter<float>, NUM_OPERATORS> sustains = make_operator_parameters([this](int o) { return Parameter<float>::make_sustain(this, sustain_names[o]); });
 
 	Parameter<float> release = Parameter<float>::make_release(this);
 
-	FMComponent(int id) : VoiceComponent(id, "FM", { { this, "MIDI In", true } }, { { this, "Out" } }) { }
+	FMComponentBase(int id, std::string name) : VoiceComponent<FMVoice<NUM_OPERATORS>>(id, name, { { this, "MIDI In", true } }, { { this, "Out" } }) { }
 
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
-	
+
 	void   serialize_custom(json::Writer & writer) const override;
 	void deserialize_custom(json::Object const & object) override;
+
+private:
+	// Parameters register themselves by address, so every Parameter is constructed in place (guaranteed copy elision)
+	template<typename Function>
+	static std::array<Parameter<float>, NUM_OPERATORS> make_operator_parameters(Function make) {
+		return [&]<int ... Is>(std::integer_sequence<int, Is ...>) {
+			return std::array<Parameter<float>, NUM_OPERATORS> { make(Is) ... };
+		}(std::make_integer_sequence<int, NUM_OPERATORS>());
+	}
+
+	static constexpr char const * ratio_names  [MAX_OPERATORS] = { "ratio_0",   "ratio_1",   "ratio_2",   "ratio_3",   "ratio_4",   "ratio_5",   "ratio_6",   "ratio_7" };
+	static constexpr char const * attack_names [MAX_OPERATORS] = { "attack_0",  "attack_1",  "attack_2",  "attack_3",  "attack_4",  "attack_5",  "attack_6",  "attack_7" };
+	static constexpr char const * hold_names   [MAX_OPERATORS] = { "hold_0",    "hold_1",    "hold_2",    "hold_3",    "hold_4",    "hold_5",    "hold_6",    "hold_7" };
+	static constexpr char const * decay_names  [MAX_OPERATORS] = { "decay_0",   "decay_1",   "decay_2",   "decay_3",   "decay_4",   "decay_5",   "decay_6",   "decay_7" };
+	static constexpr char const * sustain_names[MAX_OPERATORS] = { "sustain_0", "sustain_1", "sustain_2", "sustain_3", "sustain_4", "sustain_5", "sustain_6", "sustain_7" };
+
+	static constexpr float ratio_defaults[MAX_OPERATORS] = { 1.0f, 2.0f, 4.0f, 8.0f, 1.0f, 2.0f, 4.0f, 8.0f };
+
+	void render_voices(struct Synth const & synth, int first_voice, int num_voices);
+};
+
+struct FMComponent : FMComponentBase<4> {
+	FMComponent(int id) : FMComponentBase(id, "FM") { }
+};
+
+struct FM6Component : FMComponentBase<6> {
+	FM6Component(int id) : FMComponentBase(id, "FM 6-Op") { }
+};
+
+struct FM8Component : FMComponentBase<8> {
+	FM8Component(int id) : FMComponentBase(id, "FM 8-Op") { }
 };
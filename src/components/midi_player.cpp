@@ -2,6 +2,8 @@
 
 #include "synth/synth.h"
 
+#include "util/thread_pool.h"
+
 void MIDIPlayerComponent::load(char const * file) {
 	filename = file;
 	
@@ -15,23 +17,16 @@ void MIDIPlayerComponent::load(char const * file) {
 
 	notes.clear();
 
-	auto track = midi::Track::load(file);
-
-	if (!track.has_value()) {
-		midi_offset = 0;
-		midi_length = 0;
-		return;
-	}
-
-	midi = std::move(track.value());
+	midi_offset = 0;
+	midi_length = 0;
 
-	if (midi.events.size() == 0) {
-		midi_length = 0;
-	} else {		
-		midi_length = util::round_up(midi.events[midi.events.size() - 1].time, 4 * midi.ticks);
-	}
+	midi_loading = util::get_thread_pool().submit([file = filename]() {
+		return midi::Track::load(file.c_str());
+	});
+}
 
-	midi_offset = 0;
+bool MIDIPlayerComponent::is_ready() const {
+	return !midi_loading.valid() || util::is_ready(midi_loading);
 }
 
 void MIDIPlayerComponent::update(Synth const & synth) {
@@ -39,6 +34,17 @@ void MIDIPlayerComponent::update(Synth const & synth) {
 		return SAMPLE_RATE * time * 60 / (bpm * ticks);
 	};
 
+	if (util::is_ready(midi_loading)) {
+		auto track = midi_loading.get();
+
+		if (track.has_value() && track->events.size() > 0) {
+			midi = std::move(track.value());
+
+			midi_offset = 0;
+			midi_length = util::round_up(midi.events[midi.events.size() - 1].time, 4 * midi.ticks);
+		}
+	}
+
 	if (midi_length == 0) return;
 
 	auto sixteenth_note = size_t(60) * SAMPLE_RATE / (4 * synth.settings.tempo);
@@ -94,7 +100,11 @@ void MIDIPlayerComponent::update(Synth const & synth) {
 }
 
 void MIDIPlayerComponent::render(Synth const & synth) {
-	ImGui::Text("%s", filename_display);
+	if (midi_loading.valid()) {
+		ImGui::Text("%s (Loading)", filename_display);
+	} else {
+		ImGui::Text("%s", filename_display);
+	}
 	ImGui::SameLine();
 	
 	if (ImGui::Button("Load")) {
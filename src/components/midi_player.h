@@ -1,4 +1,6 @@
 #pragma once
+#include <future>
+
 #include "component.h"
 
 #include "synth/midi.h"
@@ -7,8 +9,8 @@ struct MIDIPlayerComponent : Component {
 	static constexpr char const * DEFAULT_FILENAME = "midi/melody_2.mid";
 
 	midi::Track midi;
-	int         midi_offset;
-	int         midi_length;
+	int         midi_offset = 0;
+	int         midi_length = 0;
 
 	std::string  filename;
 	char const * filename_display;
@@ -17,14 +19,19 @@ struct MIDIPlayerComponent : Component {
 		load(DEFAULT_FILENAME);
 	}
 
+	// The file is loaded in the background, no notes are played until it has arrived
 	void load(char const * file);
 
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
+
+	bool is_ready() const override;
 	
 	void   serialize_custom(json::Writer & writer) const override;
 	void deserialize_custom(json::Object const & object) override;
 
 private:
 	std::vector<Note> notes;
+
+	std::future<std::optional<midi::Track>> midi_loading; // Valid while the file is being loaded
 };
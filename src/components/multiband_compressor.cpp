@@ -0,0 +1,145 @@
+#include "multiband_compressor.h"
+
+void MultibandCompressorComponent::calc_crossovers() {
+	auto changed = num_bands != applied_num_bands;
+
+	for (int c = 0; c < num_bands - 1; c++) {
+		if (crossovers[c] != applied_crossovers[c]) changed = true;
+	}
+
+	if (!changed) return;
+
+	// Crossovers are kept in increasing order, so that no band ends up empty
+	float freqs[MAX_BANDS - 1];
+
+	for (int c = 0; c < num_bands - 1; c++) {
+		freqs[c] = c > 0 ? std::max(float(crossovers[c]), freqs[c - 1]) : float(crossovers[c]);
+
+		applied_crossovers[c] = crossovers[c];
+	}
+
+	if (num_bands != applied_num_bands) {
+		for (auto & env : envs) std::fill(env, env + simd::WIDTH, 0.0f);
+	}
+
+	crossover.set_crossovers(freqs, num_bands);
+	applied_num_bands = num_bands;
+}
+
+void MultibandCompressorComponent::update(Synth const & synth) {
+	calc_crossovers();
+
+	Sample input[BLOCK_SIZE];
+	for (int i = 0; i < BLOCK_SIZE; i++) input[i] = inputs[0].get_sample(i);
+
+	alignas(16) simd::float4 bands[BLOCK_SIZE][dsp::Crossover::MAX_PAIRS];
+	crossover.process(input, bands);
+
+	switch (crossover.get_num_pairs()) {
+		case 1: compress<1>(bands); break;
+		case 2: compress<2>(bands); break;
+		case 3: compress<3>(bands); break;
+
+		default: abort();
+	}
+}
+
+// The detectors, envelopes and gains of all bands are updated together in a single pass over the block
+// The crossover outputs both channels of two bands per register, the two pairs in a group are combined into one register with a lane per band
+// so that the level and gain conversions are shared by four bands
+template<int NUM_PAIRS>
+void MultibandCompressorComponent::compress(simd::float4 const bands[BLOCK_SIZE][dsp::Crossover::MAX_PAIRS]) {
+	static constexpr auto NUM_GROUPS = (NUM_PAIRS + 1) / 2;
+
+	static_assert(NUM_GROUPS <= MAX_GROUPS);
+
+	// Settings per band, in the same lanes as the envelopes
+	alignas(16) float threshold   [NUM_GROUPS][simd::WIDTH];
+	alignas(16) float slope       [NUM_GROUPS][simd::WIDTH];
+	alignas(16) float gain        [NUM_GROUPS][simd::WIDTH];
+	alignas(16) float coef_attack [NUM_GROUPS][simd::WIDTH];
+	alignas(16) float coef_release[NUM_GROUPS][simd::WIDTH];
+
+	for (int band = 0; band < NUM_GROUPS * simd::WIDTH; band++) {
+		auto b = std::min(band, MAX_BANDS - 1); // Padding lanes have no signal, any settings will do
+
+		auto group = band / simd::WIDTH;
+		auto lane  = band % simd::WIDTH;
+
+		threshold   [group][lane] = thresholds[b];
+		slope       [group][lane] = 1.0f / ratios[b] - 1.0f;
+		gain        [group][lane] = gains[b];
+		coef_attack [group][lane] = std::exp(-1000.0f / (attacks [b] * SAMPLE_RATE));
+		coef_release[group][lane] = std::exp(-1000.0f / (releases[b] * SAMPLE_RATE));
+	}
+
+	auto db_per_octave  = 20.0f * std::log10(2.0f);
+	auto octaves_per_db = 1.0f / db_per_octave;
+
+	simd::float4 env[NUM_GROUPS];
+	for (int g = 0; g < NUM_GROUPS; g++) env[g] = simd::float4::load(envs[g]);
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		auto sum = simd::float4(0.0f);
+
+		for (int g = 0; g < NUM_GROUPS; g++) {
+			auto has_hi = 2 * g + 1 < NUM_PAIRS; // Known at compile time, the last group may only have one pair
+
+			auto lo = bands[i][2 * g];
+			auto hi = has_hi ? bands[i][2 * g + 1] : simd::float4(0.0f);
+
+			// Peak of both channels of every band
+			auto abs_lo = simd::abs(lo);
+			auto abs_hi = simd::abs(hi);
+			auto level  = simd::max(simd::deinterleave_even(abs_lo, abs_hi), simd::deinterleave_odd(abs_lo, abs_hi));
+
+			auto exceeded_db = simd::max(db_per_octave * simd::log2_fast(level) - simd::float4::load(threshold[g]), simd::float4(0.0f));
+
+			auto coef = simd::select(exceeded_db >= env[g], simd::float4::load(coef_attack[g]), simd::float4::load(coef_release[g]));
+			env[g] = exceeded_db + coef * (env[g] - exceeded_db);
+
+			auto gain_db     = env[g] * simd::float4::load(slope[g]) + simd::float4::load(gain[g]);
+			auto gain_linear = simd::exp2_fast(gain_db * octaves_per_db);
+
+			// Back to the layout of the crossover, (band, band, band + 1, band + 1)
+			sum += simd::interleave_lo(gain_linear, gain_linear) * lo;
+			if (has_hi) {
+				sum += simd::interleave_hi(gain_linear, gain_linear) * hi;
+			}
+		}
+
+		outputs[0].set_sample(i, Sample(sum[0] + sum[2], sum[1] + sum[3]));
+	}
+
+	for (int g = 0; g < NUM_GROUPS; g++) env[g].store(envs[g]);
+}
+
+void MultibandCompressorComponent::render(Synth const & synth) {
+	char label[128] = { };
+
+	num_bands.render();
+
+	for (int c = 0; c < num_bands - 1; c++) {
+		ImGui::SameLine();
+		crossovers[c].render();
+	}
+
+	if (ImGui::BeginTabBar("Bands")) {
+		for (int b = 0; b < num_bands; b++) {
+			sprintf_s(label, "Band %i", b);
+
+			if (ImGui::BeginTabItem(label)) {
+				thresholds[b].render(); ImGui::SameLine();
+				ratios    [b].render(); ImGui::SameLine();
+				gains     [b].render();
+
+				attacks [b].render(); ImGui::SameLine();
+				releases[b].render();
+
+				ImGui::EndTabItem();
+			}
+		}
+
+		ImGui::EndTabBar();
+	}
+}
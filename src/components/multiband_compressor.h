@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+
+#include "component.h"
+
+#include "dsp/crossover.h"
+
+// Compressor per band of a Linkwitz-Riley crossover, the bands are compressed the same way as by CompressorComponent
+struct MultibandCompressorComponent : Component {
+	static constexpr auto MAX_BANDS = 5;
+
+	static_assert(MAX_BANDS <= dsp::Crossover::MAX_BANDS);
+
+	Parameter<int> num_bands = { this, "num_bands", "Bands", "Number of Bands", 3, std::make_pair(2, MAX_BANDS) };
+
+	std::array<Parameter<float>, MAX_BANDS - 1> crossovers = make_parameters<MAX_BANDS - 1>([this](int c) { return Parameter<float>(this, crossover_names[c], "Freq", "Crossover Frequency", crossover_defaults[c], std::make_pair(20.0f, 20000.0f), { 50, 100, 200, 400, 800, 1600, 3200, 6400, 12800 }, Param::Curve::LOGARITHMIC); });
+
+	std::array<Parameter<float>, MAX_BANDS> thresholds = make_parameters<MAX_BANDS>([this](int b) { return Parameter<float>(this, threshold_names[b], "Thrs", "Threshold (dB)", 0.0f, std::make_pair(-60.0f,   0.0f)); });
+	std::array<Parameter<float>, MAX_BANDS> ratios     = make_parameters<MAX_BANDS>([this](int b) { return Parameter<float>(this, ratio_names    [b], "Rat",  "Ratio",          1.0f, std::make_pair(  1.0f,  30.0f)); });
+	std::array<Parameter<float>, MAX_BANDS> gains      = make_parameters<MAX_BANDS>([this](int b) { return Parameter<float>(this, gain_names     [b], "Gain", "Gain (dB)",      0.0f, std::make_pair(-30.0f,  30.0f)); });
+	std::array<Parameter<float>, MAX_BANDS> attacks    = make_parameters<MAX_BANDS>([this](int b) { return Parameter<float>(this, attack_names   [b], "Att",  "Attack (ms)",   15.0f, std::make_pair(  0.0f, 400.0f)); });
+	std::array<Parameter<float>, MAX_BANDS> releases   = make_parameters<MAX_BANDS>([this](int b) { return Parameter<float>(this, release_names  [b], "Rel",  "Release (ms)", 200.0f, std::make_pair(  0.0f, 400.0f)); });
+
+	MultibandCompressorComponent(int id) : Component(id, "Multiband Compressor", { { this, "Input" } }, { { this, "Out" } }) { }
+
+	void update(struct Synth const & synth) override;
+	void render(struct Synth const & synth) override;
+
+private:
+	static constexpr auto MAX_GROUPS = (MAX_BANDS + simd::WIDTH - 1) / simd::WIDTH;
+
+	dsp::Crossover crossover;
+
+	// Crossover settings the filters were last designed for, they are only redesigned when these change
+	int   applied_num_bands = -1;
+	float applied_crossovers[MAX_BANDS - 1] = { };
+
+	// Gain reduction in dB per band, bands are grouped by simd::WIDTH with one lane per band (both channels of a band share their envelope)
+	alignas(16) float envs[MAX_GROUPS][simd::WIDTH] = { };
+
+	// Parameters register themselves by address, so every Parameter is constructed in place (guaranteed copy elision)
+	template<int N, typename Function>
+	static std::array<Parameter<float>, N> make_parameters(Function make) {
+		return [&]<int ... Is>(std::integer_sequence<int, Is ...>) {
+			return std::array<Parameter<float>, N> { make(Is) ... };
+		}(std::make_integer_sequence<int, N>());
+	}
+
+	static constexpr char const * crossover_names[MAX_BANDS - 1] = { "crossover_0", "crossover_1", "crossover_2", "crossover_3" };
+
+	static constexpr char const * threshold_names[MAX_BANDS] = { "threshold_0", "threshold_1", "threshold_2", "threshold_3", "threshold_4" };
+	static constexpr char const * ratio_names    [MAX_BANDS] = { "ratio_0",     "ratio_1",     "ratio_2",     "ratio_3",     "ratio_4" };
+	static constexpr char const * gain_names     [MAX_BANDS] = { "gain_0",      "gain_1",      "gain_2",      "gain_3",      "gain_4" };
+	static constexpr char const * attack_names   [MAX_BANDS] = { "attack_0",    "attack_1",    "attack_2",    "attack_3",    "attack_4" };
+	static constexpr char const * release_names  [MAX_BANDS] = { "release_0",   "release_1",   "release_2",   "release_3",   "release_4" };
+
+	static constexpr float crossover_defaults[MAX_BANDS - 1] = { 150.0f, 1500.0f, 5000.0f, 10000.0f };
+
+	void calc_crossovers();
+
+	template<int NUM_PAIRS>
+	void compress(simd::float4 const bands[BLOCK_SIZE][dsp::Crossover::MAX_PAIRS]);
+};
@@ -5,36 +5,22 @@
 #include "synth/synth.h"
 #include "util/util.h"
 
-static Sample generate_sine(float phase_left, float phase_right) {
-	return {
-		std::sin(TWO_PI * phase_left),
-		std::sin(TWO_PI * phase_right)
-	};
+using simd::float4;
+
+static float4 generate_sine(float4 phase) {
+	return simd::sin_turns(phase);
 }
 
-static Sample generate_square(float phase_left, float phase_right, float pulse_width = 0.5f) {
-	return {
-		std::fmodf(phase_left,  1.0f) < pulse_width ? 1.0f : -1.0f,
-		std::fmodf(phase_right, 1.0f) < pulse_width ? 1.0f : -1.0f
-	};
+static float4 generate_square(float4 phase, float pulse_width = 0.5f) {
+	return simd::select(simd::frac(phase) < pulse_width, float4(1.0f), float4(-1.0f));
 }
 
-static Sample generate_triangle(float phase_left, float phase_right) {
-	return {
-		4.0f * std::abs(phase_left  + 0.25f - std::floor(phase_left  + 0.75f)) - 1.0f,
-		4.0f * std::abs(phase_right + 0.25f - std::floor(phase_right + 0.75f)) - 1.0f
-	};
+static float4 generate_triangle(float4 phase) {
+	return 4.0f * simd::abs(phase + 0.25f - simd::floor(phase + 0.75f)) - 1.0f;
 }
 	
-static Sample generate_saw(float phase_left, float phase_right) {
-	return {
-		2.0f * (phase_left  - std::floor(phase_left  + 0.5f)),
-		2.0f * (phase_right - std::floor(phase_right + 0.5f))
-	};
-}
-
-static Sample generate_noise(unsigned & seed) {
-	return util::randf(seed) * 2.0f - 1.0f;
+static float4 generate_saw(float4 phase) {
+	return 2.0f * (phase - simd::floor(phase + 0.5f));
 }
 
 void OscillatorComponent::update(Synth const & synth) {
@@ -42,62 +28,144 @@ void OscillatorComponent::update(Synth const & synth) {
 
 	update_voices(steps_per_second);
 
-	auto sign = invert ? -1.0f : 1.0f;
+	PortamentoState portamento_max = { -1, portamento_frequency };
 
-	struct PortamentoState {
-		int   index;
-		float frequency;
-	};
+	for (int v = 0; v < voices.size(); v += simd::WIDTH) {
+		render_voices(synth, v, std::min(simd::WIDTH, int(voices.size()) - v), portamento_max);
+	}
 
-	PortamentoState portamento_max = { -1, portamento_frequency };
+	portamento_frequency = portamento_max.frequency;
+}
+
+void OscillatorComponent::voice_started(int index) {
+	// Unison sub voices start at random phases to avoid a comb filtering sweep at the start of every note
+	voice_state.phase[0][index] = 0.0f;
+	for (int u = 1; u < MAX_UNISON; u++) voice_state.phase[u][index] = util::randf(seed);
+
+	clear_filter_state(index);
+}
+
+void OscillatorComponent::voice_moved(int from, int to) {
+	for (int u = 0; u < MAX_UNISON; u++) voice_state.phase[u][to] = voice_state.phase[u][from];
 
-	for (int v = 0; v < voices.size(); v++) {
-		auto & voice = voices[v];
+	voice_state.filter_state_1_left [to] = voice_state.filter_state_1_left [from];
+	voice_state.filter_state_2_left [to] = voice_state.filter_state_2_left [from];
+	voice_state.filter_state_1_right[to] = voice_state.filter_state_1_right[from];
+	voice_state.filter_state_2_right[to] = voice_state.filter_state_2_right[from];
+
+	clear_filter_state(from);
+}
+
+void OscillatorComponent::voice_removed(int index) {
+	clear_filter_state(index);
+}
+
+// Lanes without a Voice still run through the filter, a cleared state keeps them silent
+void OscillatorComponent::clear_filter_state(int index) {
+	voice_state.filter_state_1_left [index] = 0.0f;
+	voice_state.filter_state_2_left [index] = 0.0f;
+	voice_state.filter_state_1_right[index] = 0.0f;
+	voice_state.filter_state_2_right[index] = 0.0f;
+}
+
+// Renders up to simd::WIDTH Voices starting at first_voice, with one Voice per SIMD lane
+void OscillatorComponent::render_voices(Synth const & synth, int first_voice, int num_voices, PortamentoState & portamento_max) {
+	static_assert(MAX_VOICES % simd::WIDTH == 0);
+
+	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+	auto samples_per_step = SAMPLE_RATE / steps_per_second;
+
+	auto R = std::min(1.0f - flt_resonance, 0.999f); // Filter damping
+
+	auto envelope_amp = dsp::Envelope::from_steps(attack,     hold,     decay,     sustain,     release, samples_per_step);
+	auto envelope_flt = dsp::Envelope::from_steps(flt_attack, flt_hold, flt_decay, flt_sustain, 0.0f,    samples_per_step);
+
+	// Per sample inputs of the SIMD loop, interleaved by lane
+	alignas(16) float amplitudes   [BLOCK_SIZE * simd::WIDTH] = { };
+	alignas(16) float phase_deltas [BLOCK_SIZE * simd::WIDTH] = { };
+	alignas(16) float filter_gains [BLOCK_SIZE * simd::WIDTH] = { };
+	alignas(16) float filter_denoms[BLOCK_SIZE * simd::WIDTH];
+	alignas(16) float noise        [BLOCK_SIZE * simd::WIDTH];
+
+	std::fill(std::begin(filter_denoms), std::end(filter_denoms), 1.0f);
+
+	float filter_envelope[BLOCK_SIZE];
+
+	// Unison sub voices are spread evenly over [-1, 1] in both detune and panning
+	// Noise has no pitch to detune, so it is never stacked
+	auto num_unison = waveform == 6 ? 1 : int(unison);
+
+	float unison_ratios    [MAX_UNISON];
+	float unison_gain_left [MAX_UNISON];
+	float unison_gain_right[MAX_UNISON];
+
+	for (int u = 0; u < num_unison; u++) {
+		auto spread = num_unison > 1 ? 2.0f * float(u) / float(num_unison - 1) - 1.0f : 0.0f;
+		auto pan    = spread * unison_stereo;
+
+		auto gain = 1.0f / std::sqrt(float(num_unison));
+
+		unison_ratios    [u] = std::pow(2.0f, spread * unison_detune / 1200.0f);
+		unison_gain_left [u] = gain * std::min(1.0f, 1.0f - pan);
+		unison_gain_right[u] = gain * std::min(1.0f, 1.0f + pan);
+	}
+
+	auto max_unison_ratio = std::pow(2.0f, (num_unison > 1 ? float(unison_detune) : 0.0f) / 1200.0f);
+
+	int wavetable_levels[simd::WIDTH] = { };
+
+	// Evaluate envelopes and pitch of each Voice (scalar)
+	for (int lane = 0; lane < num_voices; lane++) {
+		auto & voice = voices[first_voice + lane];
 		
 		auto note_frequency = util::note_freq(voice.note + transpose) * std::pow(2.0f, detune / 1200.0f);
 
 		PortamentoState portamento_voice = { 0, portamento_frequency };
 
-		for (int i = voice.get_first_sample(synth.time); i < BLOCK_SIZE; i++) {
-			auto time_in_seconds = voice.sample * SAMPLE_RATE_INV;
-			auto time_in_steps   = time_in_seconds * steps_per_second;
+		auto max_phase_delta = 0.0f;
 
-			float amplitude;
-			auto done = voice.apply_envelope(time_in_steps, attack, hold, decay, sustain, release, amplitude);
-			
-			if (done) {
-				voices.erase(voices.begin() + v);
-				v--;
+		auto first = voice.get_first_sample(synth.time);
+		auto last  = voice.apply_envelope(envelope_amp, samples_per_step, voice.sample, amplitudes + lane, first, 1.0f, simd::WIDTH);
 
-				break;
-			}
+		envelope_flt.fill(filter_envelope, first, last, voice.sample, 1.0f, INFINITY);
+
+		// Filter coefficients are evaluated at control rate and linearly interpolated in between
+		auto filter_coefficients = [&](int i, float & g, float & denom_inv) {
+			auto flt        = flt_min + flt_multiply * filter_envelope[i];
+			auto flt_cutoff = util::log_interpolate(20.f, 20000.0f, util::clamp(flt, 0.0f, 1.0f));
+
+			g         = util::tan_fast(PI * flt_cutoff * SAMPLE_RATE_INV);
+			denom_inv = 1.0f / (1.0f + (2.0f * R * g) + g * g);
+		};
 
-			Sample sample = { };
+		float g_start, denom_start;
+		if (first < last) filter_coefficients(first, g_start, denom_start);
 
-			auto phase_left  = phase + voice.phase;
-			auto phase_right = phase_left + stereo;
+		for (int control_start = first; control_start < last; control_start += CONTROL_RATE) {
+			auto control_end = std::min(control_start + CONTROL_RATE, last - 1);
 
-			// Generate selected waveform
-			switch (waveform) {
-				case 0: sample = sign * amplitude * generate_sine    (phase_left, phase_right); break;
-				case 1: sample = sign * amplitude * generate_triangle(phase_left, phase_right); break;
-				case 2: sample = sign * amplitude * generate_saw     (phase_left, phase_right); break;
-				case 3: sample = sign * amplitude * generate_square  (phase_left, phase_right); break;
-				case 4: sample = sign * amplitude * generate_square  (phase_left, phase_right, 0.25f);  break;
-				case 5: sample = sign * amplitude * generate_square  (phase_left, phase_right, 0.125f); break;
-				case 6: sample = sign * amplitude * generate_noise(seed); break;
+			float g_end, denom_end;
+			filter_coefficients(control_end, g_end, denom_end);
 
-				default: abort();
+			auto step = 1.0f / float(std::max(control_end - control_start, 1));
+
+			for (int i = control_start; i < std::min(control_start + CONTROL_RATE, last); i++) {
+				auto idx = i * simd::WIDTH + lane;
+				auto t   = float(i - control_start) * step;
+
+				filter_gains [idx] = util::lerp(g_start,     g_end,     t);
+				filter_denoms[idx] = util::lerp(denom_start, denom_end, t);
 			}
-			
-			auto flt        = flt_min + flt_multiply * util::envelope(time_in_steps, flt_attack, flt_hold, flt_decay, flt_sustain);
-			auto flt_cutoff = util::log_interpolate(20.f, 20000.0f, util::clamp(flt, 0.0f, 1.0f));
 
-			voice.filter.set(dsp::VAFilterMode::LOW_PASS, flt_cutoff, flt_resonance);
-			sample = voice.filter.process(sample);
+			g_start     = g_end;
+			denom_start = denom_end;
+		}
+
+		for (int i = first; i < last; i++) {
+			auto time_in_steps = voice.sample / samples_per_step;
+
+			auto idx = i * simd::WIDTH + lane;
 
-			outputs[0].get_sample(i) += sample;
-			
 			float frequency;
 
 			// Apply portamento
@@ -107,9 +175,8 @@ void OscillatorComponent::update(Synth const & synth) {
 				frequency = note_frequency;
 			}
 
-			// Advance phase of the wave
-			auto phase_delta = frequency * SAMPLE_RATE_INV;
-			voice.phase = std::fmod(voice.phase + phase_delta, 1.0f);
+			phase_deltas[idx] = frequency * SAMPLE_RATE_INV;
+			max_phase_delta = std::max(max_phase_delta, phase_deltas[idx]);
 
 			voice.sample += 1.0f;
 			
@@ -124,9 +191,107 @@ void OscillatorComponent::update(Synth const & synth) {
 		if (portamento_voice.index > portamento_max.index) {
 			portamento_max = portamento_voice;
 		}
+
+		wavetable_levels[lane] = dsp::WaveTable::get_level(max_phase_delta * max_unison_ratio);
 	}
 
-	portamento_frequency = portamento_max.frequency;
+	if (waveform == 6) {
+		for (auto & n : noise) n = util::randf(seed) * 2.0f - 1.0f;
+	}
+
+	auto sign = invert ? -1.0f : 1.0f;
+
+	auto phase_offset_left  = float(phase);
+	auto phase_offset_right = phase_offset_left + stereo;
+
+	// Generate waveforms and apply filters (SIMD)
+	auto render = [&](auto generate) {
+		float4 voice_phase[MAX_UNISON];
+		for (int u = 0; u < num_unison; u++) voice_phase[u] = float4::load(&voice_state.phase[u][first_voice]);
+
+		auto state_1_left  = float4::load(&voice_state.filter_state_1_left [first_voice]);
+		auto state_2_left  = float4::load(&voice_state.filter_state_2_left [first_voice]);
+		auto state_1_right = float4::load(&voice_state.filter_state_1_right[first_voice]);
+		auto state_2_right = float4::load(&voice_state.filter_state_2_right[first_voice]);
+
+		auto two_R = float4(2.0f * R);
+
+		auto filter = [two_R](float4 sample, float4 g, float4 denom_inv, float4 & state_1, float4 & state_2) {
+			auto high_pass = (sample - (two_R + g) * state_1 - state_2) * denom_inv;
+			auto band_pass = high_pass * g + state_1;
+			auto  low_pass = band_pass * g + state_2;
+	
+			state_1 = g * high_pass + band_pass;
+			state_2 = g * band_pass + low_pass;
+
+			return low_pass;
+		};
+
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			auto idx = i * simd::WIDTH;
+
+			auto amplitude = float4::load(&amplitudes   [idx]) * sign;
+			auto g         = float4::load(&filter_gains [idx]);
+			auto denom_inv = float4::load(&filter_denoms[idx]);
+
+			auto phase_delta = float4::load(&phase_deltas[idx]);
+
+			float4 sample_left;
+			float4 sample_right;
+
+			for (int u = 0; u < num_unison; u++) {
+				auto phase_left  = voice_phase[u] + phase_offset_left;
+				auto phase_right = voice_phase[u] + phase_offset_right;
+
+				sample_left  += unison_gain_left [u] * generate(phase_left,  idx);
+				sample_right += unison_gain_right[u] * generate(phase_right, idx);
+
+				// Advance phase of the wave
+				voice_phase[u] = simd::frac(voice_phase[u] + phase_delta * unison_ratios[u]);
+			}
+
+			sample_left  *= amplitude;
+			sample_right *= amplitude;
+
+			sample_left  = filter(sample_left,  g, denom_inv, state_1_left,  state_2_left);
+			sample_right = filter(sample_right, g, denom_inv, state_1_right, state_2_right);
+
+			// The filter gain is only zero outside of [first, last) of a Voice (or for lanes without a Voice),
+			// where the filter would otherwise output its frozen state as a constant offset
+			auto active = g > float4(0.0f);
+			sample_left  = simd::select(active, sample_left,  float4(0.0f));
+			sample_right = simd::select(active, sample_right, float4(0.0f));
+
+			outputs[0].get_sample(i) += Sample(simd::hsum(sample_left), simd::hsum(sample_right));
+		}
+
+		for (int u = 0; u < num_unison; u++) voice_phase[u].store(&voice_state.phase[u][first_voice]);
+
+		state_1_left .store(&voice_state.filter_state_1_left [first_voice]);
+		state_2_left .store(&voice_state.filter_state_2_left [first_voice]);
+		state_1_right.store(&voice_state.filter_state_1_right[first_voice]);
+		state_2_right.store(&voice_state.filter_state_2_right[first_voice]);
+	};
+
+	// Generate selected waveform, sine and noise have nothing to band limit
+	if (band_limited && waveform >= 1 && waveform <= 5) {
+		auto const & wavetable = dsp::get_basic_wavetable(waveform);
+
+		render([&](float4 phase, int idx) { return wavetable.sample(phase, wavetable_levels); });
+		return;
+	}
+
+	switch (waveform) {
+		case 0: render([](float4 phase, int idx) { return generate_sine    (phase); }); break;
+		case 1: render([](float4 phase, int idx) { return generate_triangle(phase); }); break;
+		case 2: render([](float4 phase, int idx) { return generate_saw     (phase); }); break;
+		case 3: render([](float4 phase, int idx) { return generate_square  (phase); }); break;
+		case 4: render([](float4 phase, int idx) { return generate_square  (phase, 0.25f);  }); break;
+		case 5: render([](float4 phase, int idx) { return generate_square  (phase, 0.125f); }); break;
+		case 6: render([&noise](float4 phase, int idx) { return float4::load(&noise[idx]); }); break;
+
+		default: abort();
+	}
 }
 
 void OscillatorComponent::render(Synth const & synth) {
@@ -150,6 +315,8 @@ void OscillatorComponent::render(Synth const & synth) {
 		strcpy_s(fmt, len, value ? "True" : "False");
 	};
 
+	band_limited.render(fmt_bool); ImGui::SameLine();
+
 	invert.render(fmt_bool); ImGui::SameLine();
 	phase .render();         ImGui::SameLine();
 	stereo.render();         ImGui::SameLine();
@@ -158,6 +325,12 @@ void OscillatorComponent::render(Synth const & synth) {
 	detune    .render(); ImGui::SameLine();
 	portamento.render();
 
+	unison       .render(); ImGui::SameLine();
+	unison_detune.render(); ImGui::SameLine();
+	unison_stereo.render(); ImGui::SameLine();
+
+	render_voice_settings();
+
 	if (ImGui::BeginTabBar("Envelopes")) {
 		if (ImGui::BeginTabItem("Vol")) {
 			attack .render(); ImGui::SameLine();
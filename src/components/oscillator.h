@@ -1,19 +1,19 @@
 #pragma once
 #include "voice.h"
 
-#include "dsp/vafilter.h"
+#include "dsp/wavetable.h"
+
+#include "util/simd.h"
 
 struct OscillatorVoice : Voice {
-	float phase  = 0.0f;
 	float sample = 0.0f;
 
-	dsp::VAFilter<Sample> filter;
-
 	OscillatorVoice(int note, float velocity, int start_time) : Voice(note, velocity, start_time) { }
 };
 
 struct OscillatorComponent : VoiceComponent<OscillatorVoice> {
-	Parameter<int> waveform = { this, "waveform", "Wav", "Waveform", 2, std::make_pair(0, 6) };
+	Parameter<int> waveform     = { this, "waveform",     "Wav", "Waveform",     2, std::make_pair(0, 6) };
+	Parameter<int> band_limited = { this, "band_limited", "BL",  "Band Limited", 1, std::make_pair(0, 1) }; // Use mip mapped wavetables instead of the naive (aliasing) waveforms
 	
 	Parameter<int>   invert  = { this, "invert", "Inv", "Invert Waveform",     0, std::make_pair(0, 1) };
 	Parameter<float> phase   = { this, "phase",  "Phs", "Phase Offset",        0, std::make_pair(0.0f, 1.0f), { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f } };
@@ -24,6 +24,13 @@ struct OscillatorComponent : VoiceComponent<OscillatorVoice> {
 
 	Parameter<float> portamento = { this, "portamento", "Por",  "Portamento", 0.0f, std::make_pair(0.0f, 16.0f), { 1, 2, 3, 4, 8, 16 } };
 
+	// Unison, every note is a stack of detuned sub voices that share one envelope and one filter
+	static constexpr auto MAX_UNISON = 16;
+
+	Parameter<int>   unison        = { this, "unison",        "Uni", "Unison Voices",                 1, std::make_pair(1, MAX_UNISON),    { 1, 2, 3, 5, 7, 9, 16 } };
+	Parameter<float> unison_detune = { this, "unison_detune", "Spr", "Unison Detune Spread (cents)", 20.0f, std::make_pair(0.0f, 100.0f), { 0.0f, 10.0f, 20.0f, 50.0f } };
+	Parameter<float> unison_stereo = { this, "unison_stereo", "Wid", "Unison Stereo Spread",          0.5f, std::make_pair(0.0f, 1.0f) };
+
 	// Volume envelope
 	Parameter<float> attack  = Parameter<float>::make_attack (this);
 	Parameter<float> hold    = Parameter<float>::make_hold   (this);
@@ -41,13 +48,41 @@ struct OscillatorComponent : VoiceComponent<OscillatorVoice> {
 	Parameter<float> flt_multiply  = { this, "flt_multiply",  "Amt", "Filter Amount",         0.0f, std::make_pair(-1.0f, 1.0f), { 0.0f } };
 	Parameter<float> flt_resonance = { this, "flt_resonance", "Res", "Filter Resonance",      0.0f, std::make_pair( 0.0f, 1.0f) };
 	
-	OscillatorComponent(int id) : VoiceComponent(id, "Oscillator", { { this, "MIDI In", true } }, { { this, "Out" } }) { }
+	OscillatorComponent(int id) : VoiceComponent(id, "Oscillator", { { this, "MIDI In", true } }, { { this, "Out" } }) {
+		dsp::get_basic_wavetable(0); // Make sure the wavetables are built before they are needed on the audio thread
+	}
 
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
 
 private:
+	static constexpr auto CONTROL_RATE = 32; // Number of samples between evaluations of the filter envelope
+
 	unsigned seed = util::seed();
 
 	float portamento_frequency = 0.0f;
+
+	// Per Voice state in structure of arrays form, indexed by the slot of the Voice in the pool
+	// This allows simd::WIDTH Voices to be rendered at once, one Voice per SIMD lane
+	struct {
+		alignas(16) float phase[MAX_UNISON][MAX_VOICES]; // Phase of every unison sub voice
+
+		alignas(16) float filter_state_1_left [MAX_VOICES];
+		alignas(16) float filter_state_2_left [MAX_VOICES];
+		alignas(16) float filter_state_1_right[MAX_VOICES];
+		alignas(16) float filter_state_2_right[MAX_VOICES];
+	} voice_state = { };
+
+	struct PortamentoState {
+		int   index;
+		float frequency;
+	};
+
+	void voice_started(int index) override;
+	void voice_moved(int from, int to) override;
+	void voice_removed(int index) override;
+
+	void clear_filter_state(int index);
+
+	void render_voices(struct Synth const & synth, int first_voice, int num_voices, PortamentoState & portamento_max);
 };
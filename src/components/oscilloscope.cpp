@@ -3,13 +3,7 @@
 #include <ImGui/implot.h>
 
 void OscilloscopeComponent::update(Synth const & synth) {
-	memset(samples, 0, sizeof(samples));
-
-	for (auto const & [other, weight] : inputs[0].others) {
-		for (int i = 0; i < BLOCK_SIZE; i++) {
-			samples[i] += weight * other->get_sample(i).left;
-		}
-	}
+	tap.push(inputs[0]);
 }
 
 void OscilloscopeComponent::render(Synth const & synth) {
@@ -19,6 +13,13 @@ void OscilloscopeComponent::render(Synth const & synth) {
 		avail.y - (inputs.size() + outputs.size()) * ImGui::GetTextLineHeightWithSpacing()
 	));
 
+	if (ImGui::IsRectVisible(space)) {
+		Sample latest[BLOCK_SIZE];
+		tap.read_latest(BLOCK_SIZE, latest);
+
+		for (int i = 0; i < BLOCK_SIZE; i++) samples[i] = latest[i].left;
+	}
+
 	ImPlot::SetNextPlotLimits(0.0, BLOCK_SIZE, -1.0, 1.0, ImGuiCond_Always);
 	
 	if (ImPlot::BeginPlot("Osciloscope", nullptr, nullptr, space, ImPlotFlags_CanvasOnly, ImPlotAxisFlags_NoDecorations)) {
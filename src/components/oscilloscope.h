@@ -1,6 +1,8 @@
 #pragma once
 #include "component.h"
 
+#include "synth/tap.h"
+
 struct OscilloscopeComponent : Component {
 	float samples[BLOCK_SIZE] = { };
 
@@ -8,4 +10,7 @@ struct OscilloscopeComponent : Component {
 	
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
+
+private:
+	Tap<2 * BLOCK_SIZE> tap;
 };
@@ -1,35 +1,53 @@
 #include "phaser.h"
 
+// Coefficient a of the first order all pass (a + z^-1) / (1 + a z^-1) whose phase shift is 90 degrees at the current LFO frequency
+Sample PhaserComponent::calc_coefficient() const {
+	auto all_pass_coefficient = [this](float lfo) {
+		auto frequency = util::log_interpolate<float>(min_depth, max_depth, 0.5f + 0.5f * lfo);
+
+		auto t = std::tan(PI * frequency * SAMPLE_RATE_INV);
+		return (t - 1.0f) / (t + 1.0f);
+	};
+
+	return Sample(
+		all_pass_coefficient(std::sin(TWO_PI * (lfo_phase))),
+		all_pass_coefficient(std::sin(TWO_PI * (lfo_phase + phase)))
+	);
+}
+
 void PhaserComponent::update(Synth const & synth) {
-	static constexpr auto Q_FACTOR = 0.49f;
+	// Stages that are not in use start from silence once they are turned on again
+	for (int n = num_stages; n < MAX_STAGES; n++) stage_states[n] = { };
 
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto dry = inputs[0].get_sample(i);
+	for (int control_start = 0; control_start < BLOCK_SIZE; control_start += CONTROL_RATE) {
+		lfo_phase += rate * float(CONTROL_RATE) * SAMPLE_RATE_INV;
+		lfo_phase -= std::floor(lfo_phase);
 
-		// auto lfo_left  = util::remap<float>(std::sin(TWO_PI * (lfo_phase)),         -1.0f, 1.0f, min_depth, max_depth);
-		// auto lfo_right = util::remap<float>(std::sin(TWO_PI * (lfo_phase + phase)), -1.0f, 1.0f, min_depth, max_depth);
+		auto coefficient_start = coefficient;
+		auto coefficient_end   = calc_coefficient();
 
-		auto lfo_left  = util::log_interpolate<float>(min_depth, max_depth, 0.5f + 0.5f * std::sin(TWO_PI * (lfo_phase)));
-		auto lfo_right = util::log_interpolate<float>(min_depth, max_depth, 0.5f + 0.5f * std::sin(TWO_PI * (lfo_phase + phase)));
-		
-		lfo_phase += rate * SAMPLE_RATE_INV;
+		for (int i = control_start; i < control_start + CONTROL_RATE; i++) {
+			auto dry = inputs[0].get_sample(i);
 
-		// Set up All Pass Filter
-		all_pass_left .set(dsp::BiQuadFilterMode::ALL_PASS, lfo_left,  Q_FACTOR);
-		all_pass_right.set(dsp::BiQuadFilterMode::ALL_PASS, lfo_right, Q_FACTOR);
+			auto a = util::lerp(coefficient_start, coefficient_end, float(i + 1 - control_start) / float(CONTROL_RATE));
 
-		// Apply feedback
-		auto sample = dry + feedback_sample * feedback;
+			// Apply feedback
+			auto sample = dry + feedback_sample * feedback;
 
-		// Apply All Pass Filter iteratively
-		for (int n = 0; n < num_stages; n++) {
-			sample.left  = all_pass_left .process(sample.left);
-			sample.right = all_pass_right.process(sample.right);
-		}
+			// Apply the All Pass stages in series, in transposed direct form II
+			for (int n = 0; n < num_stages; n++) {
+				auto out = a * sample + stage_states[n];
+				stage_states[n] = sample - a * out;
+
+				sample = out;
+			}
 
-		feedback_sample = sample;
+			feedback_sample = sample;
+
+			outputs[0].set_sample(i, util::lerp(dry, sample, drywet));
+		}
 
-		outputs[0].set_sample(i, util::lerp(dry, sample, drywet));
+		coefficient = coefficient_end;
 	}
 }
 
@@ -1,14 +1,14 @@
 #pragma once
 #include "component.h"
 
-#include "dsp/biquadfilter.h"
-
 struct PhaserComponent : Component {
+	static constexpr auto MAX_STAGES = 32;
+
 	Parameter<float> rate       = { this, "rate",       "Rate", "LFO Frequency",                       1.0f,  std::make_pair(0.0f, 5.0f) };
 	Parameter<float> min_depth  = { this, "min_depth",  "Min",  "Minimum Depth",                     500.0f,  std::make_pair(20.0f, 20000.0f), { }, Param::Curve::LOGARITHMIC };
 	Parameter<float> max_depth  = { this, "max_depth",  "Max",  "Maximum Depth",                    1000.0f,  std::make_pair(20.0f, 20000.0f), { }, Param::Curve::LOGARITHMIC };
 	Parameter<float> phase      = { this, "phase",      "Phs",  "Phase Offset bewteen Left and Right", 0.02f, std::make_pair(0.0f, 1.0f) };
-	Parameter<int>   num_stages = { this, "num_stages", "Num",  "Number of Stages",                    10,    std::make_pair(0, 32) };
+	Parameter<int>   num_stages = { this, "num_stages", "Num",  "Number of Stages",                    10,    std::make_pair(0, MAX_STAGES) };
 	Parameter<float> feedback   = { this, "feedback",   "FB",   "Feedback Amount",                     0.2f,  std::make_pair(0.0f, 0.9999f) };
 	Parameter<float> drywet     = { this, "drywet",     "D/W",  "Dry/Wet Ratio",                       0.7f,  std::make_pair(0.0f, 1.0f) };
 
@@ -18,10 +18,16 @@ struct PhaserComponent : Component {
 	void render(struct Synth const & synth) override;
 	
 private:
-	dsp::BiQuadFilter<float> all_pass_left  = { };
-	dsp::BiQuadFilter<float> all_pass_right = { };
+	static constexpr auto CONTROL_RATE = 32; // Number of samples between evaluations of the LFO, the all pass coefficients are interpolated in between
+
+	// First order all pass stages, every stage has its own state but all stages of a channel share the same coefficient
+	Sample stage_states[MAX_STAGES] = { };
+
+	Sample coefficient = { }; // All pass coefficient per channel at the end of the previous block
 
 	Sample feedback_sample = { };
 
 	float lfo_phase = 0.0f;
+
+	Sample calc_coefficient() const;
 };
@@ -1,25 +1,42 @@
 #include "reverb.h"
 
+// Constants from: https://ccrma.stanford.edu/~jos/pasp/Freeverb.html
+static constexpr int comb_filter_delays   [] = { 1557, 1617, 1491, 1422, 1277, 1356, 1188, 1116 };
+static constexpr int allpass_filter_delays[] = { 225, 556, 441, 341 };
+static_assert(SAMPLE_RATE == 44100, "Sample rate of 44.1kHz is assumed here!");
+
+ReverbComponent::ReverbComponent(int id) : Component(id, "Reverb", { { this, "In" } }, { { this, "Out" } }) {
+	auto max_delay = [](auto const & delays) {
+		return int(MAX_ROOM * (*std::max_element(std::begin(delays), std::end(delays)) + MAX_SPREAD));
+	};
+
+	comb_filters.resize(max_delay(comb_filter_delays));
+
+	for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
+		allpass_filters_left [i].resize(max_delay(allpass_filter_delays));
+		allpass_filters_right[i].resize(max_delay(allpass_filter_delays));
+	}
+
+	calc_comb_filter_delays();
+}
+
 void ReverbComponent::calc_comb_filter_delays() {
-	// Constants from: https://ccrma.stanford.edu/~jos/pasp/Freeverb.html
-	int comb_filter_delays[NUM_COMB_FILTERS] = { 1557, 1617, 1491, 1422, 1277, 1356, 1188, 1116 };
-	static_assert(SAMPLE_RATE == 44100, "Sample rate of 44.1kHz is assumed here!");
+	int delays[2 * NUM_COMB_FILTERS];
 
 	for (int i = 0; i < NUM_COMB_FILTERS; i++) {
-		comb_filters_left [i].set_delay(room * (comb_filter_delays[i]));
-		comb_filters_right[i].set_delay(room * (comb_filter_delays[i] + spread * MAX_SPREAD));
-
-		comb_filters_left [i].damp = damp;
-		comb_filters_right[i].damp = damp;
+		delays[i]                    = room * (comb_filter_delays[i]);
+		delays[i + NUM_COMB_FILTERS] = room * (comb_filter_delays[i] + spread * MAX_SPREAD);
 	}
 
-	calc_comb_filter_feedbacks();
+	comb_filters.set_delays(delays);
+
+	std::fill(std::begin(comb_filters.damp), std::end(comb_filters.damp), float(damp));
 
-	int allpass_delays[NUM_ALLPASS_FILTERS] = { 225, 556, 441, 341 };
+	calc_comb_filter_feedbacks();
 
 	for (int i = 0; i < NUM_ALLPASS_FILTERS; i++) {
-		allpass_filters_left [i].set_delay(room * (allpass_delays[i]));
-		allpass_filters_right[i].set_delay(room * (allpass_delays[i] + spread * MAX_SPREAD));
+		allpass_filters_left [i].set_delay(room * (allpass_filter_delays[i]));
+		allpass_filters_right[i].set_delay(room * (allpass_filter_delays[i] + spread * MAX_SPREAD));
 
 		allpass_filters_left [i].feedback = 0.5f;
 		allpass_filters_right[i].feedback = 0.5f;
@@ -27,12 +44,10 @@ void ReverbComponent::calc_comb_filter_delays() {
 }
 
 void ReverbComponent::calc_comb_filter_feedbacks() {
-	for (int i = 0; i < NUM_COMB_FILTERS; i++) {
-		auto delay_in_seconds_left  = comb_filters_left [i].history.size() * SAMPLE_RATE_INV;
-		auto delay_in_seconds_right = comb_filters_right[i].history.size() * SAMPLE_RATE_INV;
+	for (int i = 0; i < 2 * NUM_COMB_FILTERS; i++) {
+		auto delay_in_seconds = comb_filters.get_delay(i) * SAMPLE_RATE_INV;
 
-		comb_filters_left [i].feedback = std::pow(10.0f, -3.0f * delay_in_seconds_left  / decay);
-		comb_filters_right[i].feedback = std::pow(10.0f, -3.0f * delay_in_seconds_right / decay);
+		comb_filters.feedback[i] = std::pow(10.0f, -3.0f * delay_in_seconds / decay);
 	}
 }
 
@@ -40,24 +55,43 @@ void ReverbComponent::update(Synth const & synth) {
 	auto linear_dry = util::db_to_linear(dry);
 	auto linear_wet = util::db_to_linear(wet);
 
+	static constexpr auto NUM_VECTORS = decltype(comb_filters)::NUM_VECTORS;
+	static_assert(NUM_VECTORS % 2 == 0);
+
+	alignas(16) float left [BLOCK_SIZE];
+	alignas(16) float right[BLOCK_SIZE];
+
+	// Apply Comb Filters in parallel, one per SIMD lane
 	for (int i = 0; i < BLOCK_SIZE; i++) {
 		auto input = inputs[0].get_sample(i);
 
-		Sample sample = { };
+		simd::float4 x[NUM_VECTORS];
+		simd::float4 y[NUM_VECTORS];
 
-		// Apply Comb Filters in parallel
-		for (int f = 0; f < NUM_COMB_FILTERS; f++) {
-			sample.left  += comb_filters_left [f].process(input.left);
-			sample.right += comb_filters_right[f].process(input.right);
-		}
+		for (int v = 0; v < NUM_VECTORS; v++) x[v] = v < NUM_VECTORS / 2 ? input.left : input.right;
+
+		comb_filters.process(x, y);
+
+		simd::float4 sum_left;
+		simd::float4 sum_right;
 
-		// Apply All Pass Filters in series
-		for (int f = 0; f < NUM_ALLPASS_FILTERS; f++) {
-			sample.left  = allpass_filters_left [f].process(sample.left);
-			sample.right = allpass_filters_right[f].process(sample.right);
+		for (int v = 0; v < NUM_VECTORS / 2; v++) {
+			sum_left  += y[v];
+			sum_right += y[v + NUM_VECTORS / 2];
 		}
 
-		sample = linear_dry * input + linear_wet * sample;
+		left [i] = simd::hsum(sum_left);
+		right[i] = simd::hsum(sum_right);
+	}
+
+	// Apply All Pass Filters in series, one block at a time
+	for (int f = 0; f < NUM_ALLPASS_FILTERS; f++) {
+		allpass_filters_left [f].process(left,  BLOCK_SIZE);
+		allpass_filters_right[f].process(right, BLOCK_SIZE);
+	}
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		auto sample = linear_dry * inputs[0].get_sample(i) + linear_wet * Sample(left[i], right[i]);
 		outputs[0].set_sample(i, sample);
 	}
 }
@@ -74,10 +108,7 @@ void ReverbComponent::render(Synth const & synth) {
 	ImGui::SameLine();
 
 	if (damp.render()) {
-		for (int i = 0; i < NUM_COMB_FILTERS; i++) {
-			comb_filters_left [i].damp = damp;
-			comb_filters_right[i].damp = damp;
-		}
+		std::fill(std::begin(comb_filters.damp), std::end(comb_filters.damp), float(damp));
 	}
 
 	spread.render(); ImGui::SameLine();
@@ -5,64 +5,76 @@
 #include "synth/synth.h"
 
 #include "util/scope_timer.h"
+#include "util/thread_pool.h"
 
 void SamplerComponent::load(char const * file) {
+	set_filename(file);
+	request_sample();
+}
+
+void SamplerComponent::set_filename(char const * file) {
+	clear(); // Voices may still be streaming the previous sample
+
 	filename = file;
 
 	auto idx = filename.find_last_of("/\\");
 	filename_display = filename.c_str() + (idx == std::string::npos ? 0 : idx + 1);
 
-	samples = util::load_wav(file);
+	sample           = nullptr;
+	sample_requested = false;
+}
 
-	if (samples.size() == 0) {
-		visual.samples = { 0.0f };
-		return;
-	}
+void SamplerComponent::request_sample() {
+	sample_loading = util::get_thread_pool().submit([file = filename]() {
+		return sample_cache::load(file.c_str());
+	});
+	sample_requested = true;
+}
 
-	visual.samples.resize(samples.size());
+CachedSample const * SamplerComponent::get_sample() {
+	if (!sample_requested) request_sample();
 
-	for (int i = 0; i < samples.size(); i++) visual.samples[i] = 0.5f * (samples[i].left + samples[i].right);
+	// Voices that start while the sample is loading finish immediately, so none of them can be playing when it arrives
+	if (util::is_ready(sample_loading)) sample = sample_loading.get();
 
-	auto num_samples = samples.size();
+	return sample.get();
+}
 
-	while (num_samples > VISUAL_NUM_SAMPLES) {
-		for (int i = 0; i < num_samples; i += 2) {
-			auto first  = visual.samples[i];
-			auto second = visual.samples[i + 1];
+bool SamplerComponent::is_ready() const {
+	return !sample_loading.valid() || util::is_ready(sample_loading);
+}
 
-			auto diff = std::abs(first - second);
+void SamplerComponent::update(Synth const & synth) {
+	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+	auto samples_per_step = SAMPLE_RATE / steps_per_second;
 
-			if (diff > 0.2f) {
-				// Choose the sample with largest absolute amplitude
-				if (std::abs(first) > std::abs(second)) {
-					visual.samples[i/2] = first;
-				} else {
-					visual.samples[i/2] = second;
-				}
-			} else {
-				// Average the two samples
-				visual.samples[i/2] = 0.5f * (first + second);
-			}
-		}		
+	get_sample();
 
-		num_samples /= 2;
-	}
+	update_voices(steps_per_second);
 
-	visual.samples.resize(num_samples);
+	auto envelope = dsp::Envelope::from_steps(attack, hold, decay, sustain, release, samples_per_step);
 
-	visual.max_y = 0.001f;
+	switch (dsp::Interpolation(interpolation.parameter)) {
+		case dsp::Interpolation::LINEAR:  render_voices<dsp::Interpolation::LINEAR> (synth, envelope, samples_per_step); break;
+		case dsp::Interpolation::CUBIC:   render_voices<dsp::Interpolation::CUBIC>  (synth, envelope, samples_per_step); break;
+		case dsp::Interpolation::SINC_8:  render_voices<dsp::Interpolation::SINC_8> (synth, envelope, samples_per_step); break;
+		case dsp::Interpolation::SINC_32: render_voices<dsp::Interpolation::SINC_32>(synth, envelope, samples_per_step); break;
 
-	for (int i = 0; i < visual.samples.size(); i++) {
-		visual.max_y = std::max(visual.max_y, std::abs(visual.samples[i]));
+		default: abort();
 	}
 }
 
-void SamplerComponent::update(Synth const & synth) {
-	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+template<dsp::Interpolation INTERPOLATION>
+void SamplerComponent::render_voices(Synth const & synth, dsp::Envelope const & envelope, float samples_per_step) {
+	static constexpr auto TAPS   = dsp::get_taps(INTERPOLATION);
+	static constexpr auto BEFORE = TAPS / 2 - 1; // Frames needed before and after the integer part of the play position
+	static constexpr auto AFTER  = TAPS / 2;
 
-	update_voices(steps_per_second);
+	auto length = sample ? sample->length : 0;
 
-	auto sample_length = float(samples.size());
+	float amplitudes[BLOCK_SIZE];
+
+	Sample window[WINDOW_SIZE]; // Frames around the play head, decoded in bulk
 
 	for (int v = 0; v < voices.size(); v++) {
 		auto & voice = voices[v];
@@ -72,29 +84,83 @@ void SamplerComponent::update(Synth const & synth) {
 			
 		auto step = frequency_note / frequency_base;
 
-		for (int i = voice.get_first_sample(synth.time); i < BLOCK_SIZE; i++) {
-			auto time_in_seconds = voice.sample * SAMPLE_RATE_INV;
-			auto time_in_steps   = time_in_seconds * steps_per_second;
-		
-			float amplitude;
-			auto done = voice.apply_envelope(time_in_steps, attack, hold, decay, sustain, release, amplitude);
-			
-			if (done || voice.sample >= sample_length) {
-				voices.erase(voices.begin() + v);
-				v--;
+		auto level = dsp::get_sinc_level(step);
+
+		// The envelope runs at the playback rate of the sample
+		auto first = voice.get_first_sample(synth.time);
+		auto last  = voice.apply_envelope(envelope, samples_per_step, voice.sample, amplitudes, first, step);
+
+		// Frames [window_first, window_first + WINDOW_SIZE) are in the window, frames outside of the sample are silent
+		auto window_first = 0;
+		auto window_last  = 0;
+
+		auto fill_window = [&](int from, int to) {
+			auto first_valid = util::clamp(from, 0, std::max(length, 0));
+			auto last_valid  = util::clamp(to,   first_valid, length);
 
+			for (int f = from;       f < first_valid; f++) window[f - from] = 0.0f;
+			for (int f = last_valid; f < to;          f++) window[f - from] = 0.0f;
+
+			if (voice.stream.is_open()) {
+				for (int f = first_valid; f < last_valid; f++) window[f - from] = voice.stream.get_frame(f);
+			} else if (first_valid < last_valid) {
+				sample->samples.decode(first_valid, last_valid - first_valid, window + (first_valid - from));
+			}
+		};
+
+		for (int i = first; i < last; i++) {
+			if (voice.sample >= float(length)) {
+				voice.done = true;
 				break;
 			}
 
-			outputs[0].get_sample(i) += amplitude * util::sample_linear(samples.data(), samples.size(), voice.sample);
+			auto index = int(voice.sample);
+			auto t     = voice.sample - float(index);
+
+			if (index - BEFORE < window_first || index + AFTER >= window_last) {
+				auto frames_needed = std::min(int(float(last - i) * step) + TAPS + 1, WINDOW_SIZE);
+
+				window_first = index - BEFORE;
+				window_last  = window_first + frames_needed;
+
+				fill_window(window_first, window_last);
+			}
+
+			auto frames = window + (index - BEFORE - window_first);
+
+			Sample value;
+
+			if constexpr (INTERPOLATION == dsp::Interpolation::LINEAR) {
+				value = util::lerp(frames[0], frames[1], t);
+			} else if constexpr (INTERPOLATION == dsp::Interpolation::CUBIC) {
+				value = dsp::interpolate_cubic(frames, t);
+			} else {
+				value = dsp::get_sinc_table<TAPS>().interpolate(frames, t, level);
+			}
+
+			outputs[0].get_sample(i) += amplitudes[i] * value;
 
 			voice.sample += step;
 		}
+
+		if (voice.stream.is_open()) voice.stream.advance(voice.sample - float(BEFORE));
 	}
 }
 
+void SamplerComponent::voice_started(int index) {
+	if (sample && sample->streamed) voices[index].stream.open(sample->streamed);
+}
+
 void SamplerComponent::render(Synth const & synth) {
-	ImGui::Text("%s", filename_display);
+	auto data = get_sample();
+
+	if (sample_loading.valid()) {
+		ImGui::Text("%s (Loading)", filename_display);
+	} else if (data && data->streamed) {
+		ImGui::Text("%s (Streaming)", filename_display);
+	} else {
+		ImGui::Text("%s", filename_display);
+	}
 	ImGui::SameLine();
 	
 	if (ImGui::Button("Load")) {
@@ -107,7 +173,15 @@ void SamplerComponent::render(Synth const & synth) {
 	sustain.render(); ImGui::SameLine();
 	release.render();
 
-	base_note.render(util::note_name);
+	render_voice_settings(); ImGui::SameLine();
+
+	base_note.render(util::note_name); ImGui::SameLine();
+
+	auto fmt_interpolation = [](int value, char * fmt, int len) {
+		strcpy_s(fmt, len, interpolation_names[value]);
+	};
+
+	interpolation.render(fmt_interpolation);
 	ImGui::SameLine();
 	
 	auto avail = ImGui::GetContentRegionAvail();
@@ -116,16 +190,22 @@ void SamplerComponent::render(Synth const & synth) {
 		avail.y - (inputs.size() + outputs.size()) * ImGui::GetTextLineHeightWithSpacing()
 	));
 
-	ImPlot::SetNextPlotLimits(0.0, visual.samples.size(), -visual.max_y, visual.max_y, ImGuiCond_Always);
+	static constexpr float EMPTY_OVERVIEW[1] = { 0.0f };
+
+	auto overview      = data ? data->overview.data() : EMPTY_OVERVIEW;
+	auto overview_size = data ? int(data->overview.size()) : 1;
+	auto overview_max  = data ? data->overview_max : 0.001f;
+
+	ImPlot::SetNextPlotLimits(0.0, overview_size, -overview_max, overview_max, ImGuiCond_Always);
 	
 	ImPlot::PushStyleVar(ImPlotStyleVar_PlotPadding, ImVec2(0.0f, 0.0f));
 	ImPlot::PushStyleVar(ImPlotStyleVar_FillAlpha,   0.25f);
 
 	if (ImPlot::BeginPlot("Sample", nullptr, nullptr, space, ImPlotFlags_CanvasOnly, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations)) {
-		ImPlot::PlotShaded("", visual.samples.data(), visual.samples.size());
-		ImPlot::PlotLine  ("", visual.samples.data(), visual.samples.size());
+		ImPlot::PlotShaded("", overview, overview_size);
+		ImPlot::PlotLine  ("", overview, overview_size);
 
-		auto ratio = float(visual.samples.size()) / float(samples.size());
+		auto ratio = data ? float(overview_size) / float(data->length) : 0.0f;
 
 		for (auto const & voice : voices) {
 			auto t = voice.sample * ratio;
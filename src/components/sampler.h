@@ -1,8 +1,16 @@
 #pragma once
+#include <future>
+
 #include "voice.h"
 
+#include "dsp/interpolation.h"
+
+#include "synth/sample_cache.h"
+
 struct SamplerVoice : Voice {
 	float sample = 0.0f;
+
+	streaming::Stream stream; // Only open if the Sampler streams its sample from disk
 	
 	SamplerVoice(int note, float velocity, float start_time) : Voice(note, velocity, start_time) { }
 };
@@ -10,14 +18,16 @@ struct SamplerVoice : Voice {
 struct SamplerComponent : VoiceComponent<SamplerVoice> {
 	static constexpr auto DEFAULT_FILENAME = "samples/kick.wav";
 
-	static constexpr auto VISUAL_NUM_SAMPLES = 512;
+	static constexpr auto WINDOW_SIZE = 256; // Maximum number of frames that are decoded at once
+
+	static constexpr char const * interpolation_names[] = { "Linear", "Cubic", "Sinc 8", "Sinc 32" };
 
-	std::vector<Sample> samples;
-	
 	std::string  filename;
 	char const * filename_display;
 
 	Parameter<int> base_note = { this, "base_note", "Note", "Base Note", util::note<util::NoteName::C, 3>(), std::make_pair(0, 127), { 0, 12, 24, 36, 48, 60, 72, 84, 96, 108, 120 } };
+
+	Parameter<int> interpolation = { this, "interpolation", "Int", "Interpolation", int(dsp::Interpolation::SINC_8), std::make_pair(0, 3) };
 	
 	// Envelope
 	Parameter<float> attack  = Parameter<float>::make_attack (this, "attack", 0.0f);
@@ -27,20 +37,40 @@ struct SamplerComponent : VoiceComponent<SamplerVoice> {
 	Parameter<float> release = Parameter<float>::make_release(this);
 	
 	SamplerComponent(int id) : VoiceComponent(id, "Sampler", { { this, "MIDI In", true } }, { { this, "Out" } }) {
-		load(DEFAULT_FILENAME);
+		set_filename(DEFAULT_FILENAME);
+
+		// Make sure the tables are built before they are needed on the audio thread
+		dsp::get_sinc_table<dsp::get_taps(dsp::Interpolation::SINC_8)>();
+		dsp::get_sinc_table<dsp::get_taps(dsp::Interpolation::SINC_32)>();
 	}
 
+	// The file is loaded in the background, the Sampler is silent until it has arrived
 	void load(char const * filename);
 	
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
 
+	bool is_ready() const override;
+
 	void   serialize_custom(json::Writer & writer) const override;
 	void deserialize_custom(json::Object const & object) override;
 
+protected:
+	void voice_started(int index) override;
+
 private:
-	struct {
-		std::vector<float> samples;
-		float max_y;
-	} visual;
+	std::shared_ptr<CachedSample const> sample; // Shared with all other Samplers that use the same file
+	bool                                sample_requested = false;
+
+	std::future<std::shared_ptr<CachedSample const>> sample_loading; // Valid while the sample is being loaded
+
+	void set_filename(char const * file);
+	void request_sample();
+
+	// The default file is only requested when the Sampler is first updated or rendered,
+	// so a Sampler that gets deserialized right after construction never loads it
+	CachedSample const * get_sample();
+
+	template<dsp::Interpolation INTERPOLATION>
+	void render_voices(struct Synth const & synth, dsp::Envelope const & envelope, float samples_per_step);
 };
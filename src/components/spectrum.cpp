@@ -12,19 +12,45 @@ static float hamming_window(int i) {
 
 static auto const hamming_lut = util::generate_lookup_table<float, BLOCK_SIZE>(hamming_window);
 
-void SpectrumComponent::update(Synth const& synth) {
-	Sample fourier[N] = { };
+void SpectrumComponent::update(Synth const & synth) {
+	tap.push(inputs[0]);
+}
+
+void SpectrumComponent::analyse() {
+	auto position = tap.get_position();
+	if (position == analysed_position) return;
+
+	Sample samples[BLOCK_SIZE];
+	tap.read_latest(BLOCK_SIZE, samples);
+
+	// The block is zero padded to N samples, every channel gets its own real FFT so that a downmix does not cancel out side content
+	float signal_left [N] = { };
+	float signal_right[N] = { };
 	
 	for (int i = 0; i < BLOCK_SIZE; i++) {
-		fourier[i] = hamming_lut[i] * inputs[0].get_sample(i);
+		signal_left [i] = hamming_lut[i] * samples[i].left;
+		signal_right[i] = hamming_lut[i] * samples[i].right;
 	}
 
-	dsp::fft<N>(fourier);
+	Sample fourier_left [N / 2 + 1];
+	Sample fourier_right[N / 2 + 1];
+	dsp::rfft<N>(signal_left,  fourier_left);
+	dsp::rfft<N>(signal_right, fourier_right);
+
+	// Smoothing is applied per block of audio rather than per frame, so it does not depend on the frame rate
+	auto num_blocks = float(position - analysed_position) * BLOCK_SIZE_INV;
+	auto smoothing  = 1.0f - std::pow(0.9f, num_blocks);
 
 	for (int i = 0; i < N / 2; i++) {
-		auto magnitude = std::sqrt(fourier[i].left * fourier[i].left + fourier[i].right * fourier[i].right) / N;
-		magnitudes[i] = util::lerp(magnitudes[i], magnitude, 0.1f);
+		// Power of both channels, which reads the same as the packed stereo FFT this replaced for mono and side only signals
+		auto power_left  = fourier_left [i].left * fourier_left [i].left + fourier_left [i].right * fourier_left [i].right;
+		auto power_right = fourier_right[i].left * fourier_right[i].left + fourier_right[i].right * fourier_right[i].right;
+
+		auto magnitude = std::sqrt(power_left + power_right) / N;
+		magnitudes[i] = util::lerp(magnitudes[i], magnitude, smoothing);
 	}
+
+	analysed_position = position;
 }
 
 void SpectrumComponent::render(Synth const & synth) {
@@ -49,6 +75,9 @@ void SpectrumComponent::render(Synth const & synth) {
 		avail.y - (inputs.size() + outputs.size()) * ImGui::GetTextLineHeightWithSpacing()
 	));
 
+	// Only analyse when the plot is on screen, render() itself is only called when the window is not collapsed
+	if (ImGui::IsRectVisible(space)) analyse();
+
 	ImPlot::SetNextPlotLimits(FREQ_BIN_SIZE, SAMPLE_RATE / 2, -78.0f, -18.0f, ImGuiCond_Always);
 	ImPlot::SetNextPlotTicksX(ticks_x, util::array_count(ticks_x), tick_labels);
 
@@ -1,6 +1,8 @@
 #pragma once
 #include "component.h"
 
+#include "synth/tap.h"
+
 struct SpectrumComponent : Component {
 	static constexpr auto N = 4 * 1024;
 
@@ -10,4 +12,11 @@ struct SpectrumComponent : Component {
 	
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
+
+private:
+	Tap<2 * BLOCK_SIZE> tap;
+
+	int64_t analysed_position = 0; // Tap position at the time of the last FFT
+
+	void analyse();
 };
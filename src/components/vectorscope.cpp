@@ -3,13 +3,10 @@
 #include <ImGui/implot.h>
 
 void VectorscopeComponent::update(Synth const & synth) {
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		samples[sample_offset] = inputs[0].get_sample(i);
-		sample_offset = util::wrap(sample_offset + 1, NUM_SAMPLES);
-	}
+	tap.push(inputs[0]);
 }
 
-void VectorscopeComponent::render(Synth const & synth) {
+float VectorscopeComponent::compute_correlation() const {
 	auto average = Sample(0.0f);
 	for (auto const & sample : samples) average += sample;
 	average /= NUM_SAMPLES;
@@ -29,11 +26,19 @@ void VectorscopeComponent::render(Synth const & synth) {
 	variance   /= NUM_SAMPLES - 1.0f;
 	covariance /= NUM_SAMPLES - 1.0f;
 
-	float correlation;
 	if (std::abs(variance.left) < 0.0001f || std::abs(variance.right) < 0.0001f) {
-		correlation = 0.0f;
+		return 0.0f;
 	} else {
-		correlation = covariance / std::sqrt(variance.left * variance.right);
+		return covariance / std::sqrt(variance.left * variance.right);
+	}
+}
+
+void VectorscopeComponent::render(Synth const & synth) {
+	// Only fetch new samples and update the correlation when on screen, render() itself is only called when the window is not collapsed
+	if (ImGui::IsRectVisible(ImGui::GetContentRegionAvail())) {
+		tap.read_latest(NUM_SAMPLES, samples);
+
+		correlation = compute_correlation();
 	}
 
 	ImGui::Text("Correlation: %f", correlation);
@@ -1,76 +1,78 @@
 #include "vocoder.h"
 
 void VocoderComponent::calc_bands() {
-	bands.resize(num_bands);
-	
 	static constexpr auto FREQ_START =   50.0f;
 	static constexpr auto FREQ_END   = 7000.0f;
 
 	auto scale = std::pow(FREQ_END / FREQ_START, 1.0f / float(num_bands));
 
-	auto freq = FREQ_START;
+	float freqs[MAX_BANDS];
+	freqs[0] = FREQ_START;
 
-	for (auto & band : bands) {
-		band.freq = freq;
-		freq *= scale;
+	for (int b = 1; b < num_bands; b++) {
+		freqs[b] = freqs[b - 1] * scale;
+	}
+
+	filter_bank.set_bands(freqs, num_bands, width);
+
+	// Only a change in the number of bands starts over, the width can change while playing
+	if (num_bands != applied_num_bands) {
+		filter_bank.reset_state();
 
-		band.filter_mod.reset_state();
-		band.filter_mod.reset_state();
-		band.filter_car.reset_state();
-		band.filter_car.reset_state();
+		spectral_vocoder.set_bands(freqs, num_bands);
+		spectral_vocoder.reset_state();
 	}
+
+	applied_num_bands = num_bands;
+	applied_width     = width;
 }
 
 void VocoderComponent::update(Synth const & synth) {
-	for (int b = 0; b < bands.size(); b++) {
-		auto & band = bands[b];
+	if (num_bands != applied_num_bands || width != applied_width) {
+		calc_bands();
+	}
+
+	// The vocoder that was not running holds on to stale input, so switching starts from silence
+	if (mode != applied_mode) {
+		filter_bank     .reset_state();
+		spectral_vocoder.reset_state();
 
-		band.filter_mod.set(dsp::BiQuadFilterMode::BAND_PASS, band.freq, width);
-		band.filter_mod.set(dsp::BiQuadFilterMode::BAND_PASS, band.freq, width);
-		band.filter_car.set(dsp::BiQuadFilterMode::BAND_PASS, band.freq, width);
-		band.filter_car.set(dsp::BiQuadFilterMode::BAND_PASS, band.freq, width);
+		applied_mode = mode;
 	}
 
 	auto decay_factor = util::log_interpolate(0.01f, 0.00001f, decay);
 
 	auto linear_gain = util::db_to_linear(gain);
 
-	for (int i = 0; i < BLOCK_SIZE; i++) {
-		auto modulator = inputs[0].get_sample(i);
-		auto carrier   = inputs[1].get_sample(i);
-
-		Sample sample = { };
-
-		for (auto & band : bands) {
-			auto mod = band.filter_mod.process(modulator);
-			auto car = band.filter_car.process(carrier);
+	Sample modulator[BLOCK_SIZE];
+	Sample carrier  [BLOCK_SIZE];
+	Sample out      [BLOCK_SIZE];
 
-			auto mod_gain = std::max(std::abs(mod.left), std::abs(mod.right));
-
-			if (band.gain < mod_gain) {
-				band.gain = mod_gain; // Gain increases instantaneously
-			} else {
-				band.gain = util::lerp(band.gain, mod_gain, decay_factor); // Gain decreases slowly (low passed)
-			}
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		modulator[i] = inputs[0].get_sample(i);
+		carrier  [i] = inputs[1].get_sample(i);
+	}
 
-			sample += band.gain * car;
-		}
+	if (mode == 0) {
+		filter_bank.process(modulator, carrier, out, decay_factor);
+	} else {
+		spectral_vocoder.process(modulator, carrier, out, decay_factor);
+	}
 
-		outputs[0].set_sample(i, sample * linear_gain);
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		outputs[0].set_sample(i, out[i] * linear_gain);
 	}
 }
 
 void VocoderComponent::render(Synth const & synth) {
-	if (num_bands.render()) {
-		calc_bands();
-	}
-	ImGui::SameLine();
+	auto fmt_mode = [](int value, char * fmt, int len) {
+		strcpy_s(fmt, len, value == 0 ? "Bank" : "FFT");
+	};
+
+	num_bands.render();         ImGui::SameLine();
+	mode     .render(fmt_mode);
 
-	width.render();
+	width.render(); ImGui::SameLine();
 	decay.render(); ImGui::SameLine();
 	gain .render();
 }
-
-void VocoderComponent::deserialize_custom(json::Object const & object) {
-	calc_bands();
-}
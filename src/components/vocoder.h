@@ -1,34 +1,33 @@
 #pragma once
 #include "component.h"
 
-#include "dsp/biquadfilter.h"
+#include "dsp/filter_bank.h"
+#include "dsp/spectral_vocoder.h"
 
 struct VocoderComponent : Component {
-	struct Band {
-		float freq = 1000.0f;
+	static constexpr auto MAX_BANDS = dsp::VocoderFilterBank::MAX_BANDS;
 
-		dsp::BiQuadFilter<Sample> filter_mod;
-		dsp::BiQuadFilter<Sample> filter_car;
+	static_assert(MAX_BANDS <= dsp::SpectralVocoder::MAX_BANDS);
 
-		float gain = 0.0f;
-	};
-	
-	std::vector<Band> bands;
-
-	Parameter<int> num_bands = { this, "num_bands", "Bands", "Number of Bands", 16, std::make_pair(1, 64) };
+	Parameter<int> num_bands = { this, "num_bands", "Bands", "Number of Bands", 16, std::make_pair(1, MAX_BANDS) };
+	Parameter<int> mode      = { this, "mode",      "Mode",  "Filter Bank or FFT (cheaper for many bands, but adds latency)", 0, std::make_pair(0, 1) };
 
 	Parameter<float> width = { this, "width", "Q",         "Width", 5.0f, std::make_pair(0.0f, 10.0f) };
 	Parameter<float> decay = { this, "decay", "Dec",       "Decay", 0.5f, std::make_pair(0.0f,  1.0f) };
 	Parameter<float> gain  = { this, "gain",  "Gain (dB)", "Gain",  0.0f, std::make_pair(0.0f, 30.0f) };
+
+	dsp::VocoderFilterBank filter_bank;
+	dsp::SpectralVocoder   spectral_vocoder;
+
+	// Band settings the vocoders were last set up for, the filters are only redesigned when these change
+	int   applied_num_bands = -1;
+	float applied_width     = 0.0f;
+	int   applied_mode      = -1;
 	
-	VocoderComponent(int id) : Component(id, "Vocoder", { { this, "Modulator" }, { this, "Carrier" } }, { { this, "Out" } }) {
-		calc_bands();
-	}
+	VocoderComponent(int id) : Component(id, "Vocoder", { { this, "Modulator" }, { this, "Carrier" } }, { { this, "Out" } }) { }
 
 	void calc_bands();
 
 	void update(struct Synth const & synth) override;
 	void render(struct Synth const & synth) override;
-
-	void deserialize_custom(json::Object const & object) override;
 };
@@ -1,13 +1,18 @@
 #pragma once
 #include "component.h"
 
+#include "dsp/envelope.h"
+
 struct Voice {
 	int   note;
 	float velocity;
-	
+
 	int   start_time;              // In samples, absolute
 	float release_time = INFINITY; // In steps, relative to start
 
+	float amplitude = 0.0f;  // Most recent envelope amplitude, used to find the quietest Voice when stealing
+	bool  done      = false; // Set when the Voice has finished playing, it is removed at the start of the next block
+
 	Voice(int note, float velocity, int start_time) : note(note), velocity(velocity), start_time(start_time) { }
 
 	int get_first_sample(int time) const {
@@ -18,59 +23,184 @@ struct Voice {
 		}
 	}
 
-	[[nodiscard]] bool apply_envelope(float time_in_steps, float a, float h, float d, float s, float r, float & amplitude) const {
-		amplitude = velocity * util::envelope(time_in_steps, a, h, d, s);
+	// Fills the amplitudes of samples [first, BLOCK_SIZE) using the given envelope, scaled by velocity
+	// Envelope time of the Voice is given at sample first, in samples, and advances by rate every sample
+	// Returns the index of the first sample after the Voice has finished, samples from there on should not be rendered
+	int apply_envelope(dsp::Envelope const & envelope, float samples_per_step, float time, float * amplitudes, int first, float rate = 1.0f, int stride = 1) {
+		auto end = envelope.fill(amplitudes, first, BLOCK_SIZE, time, rate, release_time * samples_per_step, velocity, stride);
 
-		auto released = release_time < time_in_steps;
+		if (end > first) amplitude = amplitudes[(end - 1) * stride];
+		if (end < BLOCK_SIZE) done = true;
 
-		if (released) {
-			auto time_since_release = time_in_steps - release_time;
-
-			if (time_since_release < r) {
-				amplitude = util::lerp(amplitude, 0.0f, time_since_release / r);
-			} else {
-				return true; // Voice is done and should be removed
-			}
-		}
-
-		return false;
-	}
-
-	[[nodiscard]] bool apply_envelope(float time_in_steps, float & amplitude) const {
-		return apply_envelope(time_in_steps, 0.1f, INFINITY, 0.0f, 1.0f, 0.1f, amplitude);
+		return end;
 	}
 };
 
 template<typename TVoice> requires std::is_base_of_v<Voice, TVoice>
 struct VoiceComponent : Component {
+	static constexpr auto MAX_VOICES = 128;
+	static constexpr auto NUM_NOTES  = 128;
+
+	static constexpr char const * steal_names[] = { "Old", "Quiet", "Note" };
+
+	enum struct Steal { OLDEST, QUIETEST, SAME_NOTE };
+
+	Parameter<int> polyphony = { this, "polyphony", "Poly", "Polyphony",      64, std::make_pair(1, MAX_VOICES), { 1, 4, 8, 16, 32, 64, 128 } };
+	Parameter<int> steal     = { this, "steal",     "Stl",  "Voice Stealing",  0, std::make_pair(0, 2) };
+
 protected:
-	std::vector<TVoice> voices;
+	std::vector<TVoice> voices; // Preallocated to MAX_VOICES, so adding a Voice never allocates
 
 	VoiceComponent(int id,
 		std::string name,
 		std::vector<ConnectorIn>  && inputs,
-		std::vector<ConnectorOut> && outputs) : Component(id, name, std::move(inputs), std::move(outputs)) { }
+		std::vector<ConnectorOut> && outputs) : Component(id, name, std::move(inputs), std::move(outputs)) {
+		voices.reserve(MAX_VOICES);
+
+		std::fill(std::begin(note_to_voice), std::end(note_to_voice), -1);
+	}
+
+	void update_voices(float steps_per_second) {
+		remove_finished_voices();
 
-	void update_voices(float steps_per_second) {		
 		auto note_events = inputs[0].get_events();
 
 		for (auto const & note_event : note_events) {
 			if (note_event.pressed) {
-				voices.emplace_back(note_event.note, note_event.velocity, note_event.time);
+				press(note_event.note, note_event.velocity, note_event.time, steps_per_second);
 			} else {
-				while (true) {
-					auto voice = std::find_if(voices.begin(), voices.end(), [note = note_event.note](auto voice) {
-						return voice.note == note && std::isinf(voice.release_time);
-					});
-
-					if (voice == voices.end()) break;
-						
-					voice->release_time = float(note_event.time - voice->start_time) * SAMPLE_RATE_INV * steps_per_second;
-				}
+				release(note_event.note, note_event.time, steps_per_second);
 			}
 		}
 	}
 
+	// Hooks that allow derived Components to keep per Voice state outside of TVoice (e.g. in structure of arrays form)
+	virtual void voice_started(int index) { }
+	virtual void voice_moved(int from, int to) { }
+	virtual void voice_removed(int index) { }
+
+	void render_voice_settings() {
+		auto fmt_steal = [](int value, char * fmt, int len) {
+			strcpy_s(fmt, len, steal_names[value]);
+		};
+
+		polyphony.render(); ImGui::SameLine();
+		steal    .render(fmt_steal);
+	}
+
 public:
-	void clear() { voices.clear(); }
+	void clear() {
+		voices.clear();
+
+		std::fill(std::begin(note_to_voice), std::end(note_to_voice), -1);
+	}
+
+private:
+	int note_to_voice[NUM_NOTES]; // Index of the held (not yet released) Voice playing each note, or -1
+
+	static bool is_valid_note(int note) { return note >= 0 && note < NUM_NOTES; }
+
+	void press(int note, float velocity, int time, float steps_per_second) {
+		if (is_valid_note(note) && note_to_voice[note] != -1) {
+			// Retrigger of a note that is still held, release the old Voice at this point in time
+			auto & voice = voices[note_to_voice[note]];
+			voice.release_time = std::min(voice.release_time, float(time - voice.start_time) * SAMPLE_RATE_INV * steps_per_second);
+			note_to_voice[note] = -1;
+		}
+
+		int index;
+
+		if (voices.size() < polyphony) {
+			index = int(voices.size());
+			voices.emplace_back(note, velocity, time);
+		} else {
+			index = find_voice_to_steal(note);
+
+			auto old_note = voices[index].note;
+			if (is_valid_note(old_note) && note_to_voice[old_note] == index) note_to_voice[old_note] = -1;
+
+			voices[index] = TVoice(note, velocity, time);
+		}
+
+		if (is_valid_note(note)) note_to_voice[note] = index;
+
+		voice_started(index);
+	}
+
+	void release(int note, int time, float steps_per_second) {
+		auto release_voice = [=](TVoice & voice) {
+			voice.release_time = float(time - voice.start_time) * SAMPLE_RATE_INV * steps_per_second;
+		};
+
+		if (is_valid_note(note)) {
+			auto index = note_to_voice[note];
+			if (index == -1) return;
+
+			release_voice(voices[index]);
+			note_to_voice[note] = -1;
+		} else {
+			for (auto & voice : voices) {
+				if (voice.note == note && std::isinf(voice.release_time)) release_voice(voice);
+			}
+		}
+	}
+
+	int find_voice_to_steal(int note) const {
+		assert(voices.size() > 0);
+
+		if (Steal(steal.parameter) == Steal::SAME_NOTE) {
+			for (int v = 0; v < voices.size(); v++) {
+				if (voices[v].note == note) return v;
+			}
+		}
+
+		// Prefer Voices that are already released or done over Voices that are still held
+		auto is_better_candidate = [this](TVoice const & a, TVoice const & b) {
+			auto a_held = !a.done && std::isinf(a.release_time);
+			auto b_held = !b.done && std::isinf(b.release_time);
+
+			if (a_held != b_held) return b_held;
+
+			if (Steal(steal.parameter) == Steal::QUIETEST) {
+				return a.amplitude < b.amplitude;
+			} else {
+				return a.start_time < b.start_time;
+			}
+		};
+
+		auto best = 0;
+
+		for (int v = 1; v < voices.size(); v++) {
+			if (is_better_candidate(voices[v], voices[best])) best = v;
+		}
+
+		return best;
+	}
+
+	// Compacts the Voice pool by moving the last Voice into the slot of each finished Voice
+	void remove_finished_voices() {
+		for (int v = 0; v < voices.size(); ) {
+			if (!voices[v].done) {
+				v++;
+				continue;
+			}
+
+			auto note = voices[v].note;
+			if (is_valid_note(note) && note_to_voice[note] == v) note_to_voice[note] = -1;
+
+			voice_removed(v);
+
+			auto last = int(voices.size()) - 1;
+
+			if (v != last) {
+				voices[v] = std::move(voices[last]);
+				voice_moved(last, v);
+
+				auto moved_note = voices[v].note;
+				if (is_valid_note(moved_note) && note_to_voice[moved_note] == last) note_to_voice[moved_note] = v;
+			}
+
+			voices.pop_back();
+		}
+	}
 };
@@ -0,0 +1,195 @@
+#include "wavetable.h"
+
+#include "synth/synth.h"
+
+#include "util/thread_pool.h"
+
+using simd::float4;
+
+void WavetableComponent::load(char const * file) {
+	filename = file;
+
+	auto idx = filename.find_last_of("/\\");
+	filename_display = filename.c_str() + (idx == std::string::npos ? 0 : idx + 1);
+
+	frames.clear();
+
+	frames_loading = util::get_thread_pool().submit([file = filename]() {
+		return load_frames(file.c_str());
+	});
+}
+
+// Runs on a worker thread
+std::vector<dsp::WaveTable> WavetableComponent::load_frames(char const * file) {
+	auto samples = util::load_wav(file);
+	if (samples.size() == 0) return { };
+
+	std::vector<float> cycle(samples.size());
+
+	for (int i = 0; i < samples.size(); i++) cycle[i] = 0.5f * (samples[i].left + samples[i].right);
+
+	// Files whose length is a multiple of the table size are treated as a sequence of frames,
+	// which is how most wavetable synths store them. Any other file is treated as a single cycle
+	auto frame_size = cycle.size() % dsp::WaveTable::SIZE == 0 ? dsp::WaveTable::SIZE : int(cycle.size());
+	auto num_frames = int(cycle.size()) / frame_size;
+
+	if (num_frames > MAX_FRAMES) {
+		printf("WARNING: Wavetable '%s' has %i frames, only the first %i will be used\n", file, num_frames, MAX_FRAMES);
+		num_frames = MAX_FRAMES;
+	}
+
+	std::vector<dsp::WaveTable> new_frames;
+	new_frames.reserve(num_frames);
+
+	for (int f = 0; f < num_frames; f++) {
+		new_frames.emplace_back(&cycle[f * frame_size], frame_size);
+	}
+
+	return new_frames;
+}
+
+bool WavetableComponent::is_ready() const {
+	return !frames_loading.valid() || util::is_ready(frames_loading);
+}
+
+void WavetableComponent::update(Synth const & synth) {
+	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+
+	if (util::is_ready(frames_loading)) {
+		frames = frames_loading.get();
+
+		// Fall back to a saw if the file could not be loaded
+		if (frames.empty()) {
+			frames = { dsp::get_basic_wavetable(2) };
+
+			filename.clear();
+			filename_display = "Saw";
+		}
+	}
+
+	update_voices(steps_per_second);
+
+	// Voices that start while the file is loading finish immediately
+	if (frames.empty()) {
+		for (auto & voice : voices) voice.done = true;
+		return;
+	}
+
+	for (int v = 0; v < voices.size(); v += simd::WIDTH) {
+		render_voices(synth, v, std::min(simd::WIDTH, int(voices.size()) - v));
+	}
+}
+
+void WavetableComponent::voice_started(int index) {
+	phases[index] = 0.0f;
+}
+
+void WavetableComponent::voice_moved(int from, int to) {
+	phases[to] = phases[from];
+}
+
+// Renders up to simd::WIDTH Voices starting at first_voice, with one Voice per SIMD lane
+void WavetableComponent::render_voices(Synth const & synth, int first_voice, int num_voices) {
+	static_assert(MAX_VOICES % simd::WIDTH == 0);
+
+	auto steps_per_second = 4.0f / 60.0f * float(synth.settings.tempo);
+	auto samples_per_step = SAMPLE_RATE / steps_per_second;
+
+	auto envelope = dsp::Envelope::from_steps(attack, hold, decay, sustain, release, samples_per_step);
+
+	alignas(16) float amplitudes  [BLOCK_SIZE * simd::WIDTH] = { }; // Interleaved by lane
+	alignas(16) float phase_deltas[simd::WIDTH] = { };
+
+	int levels[simd::WIDTH] = { };
+
+	for (int lane = 0; lane < num_voices; lane++) {
+		auto & voice = voices[first_voice + lane];
+
+		auto frequency = util::note_freq(voice.note + transpose) * std::pow(2.0f, detune / 1200.0f);
+
+		phase_deltas[lane] = frequency * SAMPLE_RATE_INV;
+		levels      [lane] = dsp::WaveTable::get_level(phase_deltas[lane]);
+
+		auto first = voice.get_first_sample(synth.time);
+		auto last  = voice.apply_envelope(envelope, samples_per_step, voice.sample, amplitudes + lane, first, 1.0f, simd::WIDTH);
+
+		// The phase advances every sample of the block, offset it so that a Voice starting in this block is at phase zero on its first sample
+		if (voice.sample == 0.0f) phases[first_voice + lane] = -float(first) * phase_deltas[lane];
+
+		voice.sample += float(last - first);
+	}
+
+	// Crossfade between the two frames surrounding the position
+	auto frame_position = position * float(frames.size() - 1);
+	auto frame_a = std::min(int(frame_position), int(frames.size()) - 1);
+	auto frame_b = std::min(frame_a + 1,          int(frames.size()) - 1);
+	auto blend   = frame_position - float(frame_a);
+
+	auto const & table_a = frames[frame_a];
+	auto const & table_b = frames[frame_b];
+
+	auto render = [&](auto sample_table) {
+		auto phase = float4::load(&phases[first_voice]);
+		auto delta = float4::load(phase_deltas);
+
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			auto value = sample_table(table_a, phase);
+
+			if (blend > 0.0f) {
+				value = simd::lerp(value, sample_table(table_b, phase), float4(blend));
+			}
+
+			outputs[0].get_sample(i) += simd::hsum(float4::load(&amplitudes[i * simd::WIDTH]) * value);
+
+			phase = simd::frac(phase + delta);
+		}
+
+		phase.store(&phases[first_voice]);
+	};
+
+	switch (interpolation) {
+		case 0: render([&levels](dsp::WaveTable const & table, float4 phase) { return table.sample<dsp::WaveTableInterpolation::LINEAR>(phase, levels); }); break;
+		case 1: render([&levels](dsp::WaveTable const & table, float4 phase) { return table.sample<dsp::WaveTableInterpolation::CUBIC> (phase, levels); }); break;
+
+		default: abort();
+	}
+}
+
+void WavetableComponent::render(Synth const & synth) {
+	if (frames_loading.valid()) {
+		ImGui::Text("%s (Loading)", filename_display);
+	} else {
+		ImGui::Text("%s (%i frames)", filename_display, int(frames.size()));
+	}
+	ImGui::SameLine();
+
+	if (ImGui::Button("Load")) {
+		synth.file_dialog.show(FileDialog::Type::OPEN, "Open WAV File", "samples", ".wav", [this](char const * path) { load(path); });
+	}
+
+	auto fmt_interpolation = [](int value, char * fmt, int len) {
+		strcpy_s(fmt, len, value ? "Cubic" : "Linear");
+	};
+
+	position     .render(); ImGui::SameLine();
+	interpolation.render(fmt_interpolation); ImGui::SameLine();
+	transpose    .render(); ImGui::SameLine();
+	detune       .render();
+
+	attack .render(); ImGui::SameLine();
+	hold   .render(); ImGui::SameLine();
+	decay  .render(); ImGui::SameLine();
+	sustain.render(); ImGui::SameLine();
+	release.render();
+
+	render_voice_settings();
+}
+
+void WavetableComponent::serialize_custom(json::Writer & writer) const {
+	writer.write("filename", filename.c_str());
+}
+
+void WavetableComponent::deserialize_custom(json::Object const & object) {
+	auto file = object.find_string("filename", "");
+	if (file.size() > 0) load(file.c_str());
+}
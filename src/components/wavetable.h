@@ -0,0 +1,61 @@
+#pragma once
+#include <future>
+
+#include "voice.h"
+
+#include "dsp/wavetable.h"
+
+struct WavetableVoice : Voice {
+	float sample = 0.0f;
+
+	WavetableVoice(int note, float velocity, int start_time) : Voice(note, velocity, start_time) { }
+};
+
+struct WavetableComponent : VoiceComponent<WavetableVoice> {
+	static constexpr auto MAX_FRAMES = 256;
+
+	std::vector<dsp::WaveTable> frames;
+
+	std::string  filename;
+	char const * filename_display = "Saw";
+
+	Parameter<float> position      = { this, "position",      "Pos", "Wavetable Position", 0.0f, std::make_pair(0.0f, 1.0f) };
+	Parameter<int>   interpolation = { this, "interpolation", "Int", "Interpolation",      0,    std::make_pair(0, 1) };
+
+	Parameter<int>   transpose = { this, "transpose", "Tps", "Transpose (notes)", 0, std::make_pair(-24, 24),         { -24, -12, 0, 12, 24 } };
+	Parameter<float> detune    = { this, "detune",    "Dtn", "Detune (cents)", 0.0f, std::make_pair(-100.0f, 100.0f), { 0.0f } };
+
+	// Envelope
+	Parameter<float> attack  = Parameter<float>::make_attack (this);
+	Parameter<float> hold    = Parameter<float>::make_hold   (this);
+	Parameter<float> decay   = Parameter<float>::make_decay  (this);
+	Parameter<float> sustain = Parameter<float>::make_sustain(this);
+	Parameter<float> release = Parameter<float>::make_release(this);
+
+	WavetableComponent(int id) : VoiceComponent(id, "Wavetable", { { this, "MIDI In", true } }, { { this, "Out" } }) {
+		frames = { dsp::get_basic_wavetable(2) };
+	}
+
+	// The file is loaded in the background, the Wavetable is silent until it has arrived
+	void load(char const * filename);
+
+	void update(struct Synth const & synth) override;
+	void render(struct Synth const & synth) override;
+
+	bool is_ready() const override;
+
+	void   serialize_custom(json::Writer & writer) const override;
+	void deserialize_custom(json::Object const & object) override;
+
+private:
+	alignas(16) float phases[MAX_VOICES] = { }; // Indexed by the slot of the Voice in the pool
+
+	std::future<std::vector<dsp::WaveTable>> frames_loading; // Valid while the file is being loaded, empty result if loading failed
+
+	static std::vector<dsp::WaveTable> load_frames(char const * file);
+
+	void voice_started(int index) override;
+	void voice_moved(int from, int to) override;
+
+	void render_voices(struct Synth const & synth, int first_voice, int num_voices);
+};
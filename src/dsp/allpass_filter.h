@@ -1,29 +1,67 @@
-#include <vector>
+#pragma once
+#include <algorithm>
+
+#include "delay_line.h"
 
 #include "util/util.h"
+#include "util/simd.h"
 
 namespace dsp {
-	template<typename T>
-	struct AllPassFilter {
-		std::vector<T> history;
-		int            history_offset = 0;
-
+	// All pass filter that processes a whole block at once, in chunks of at most delay samples
+	// Every chunk only depends on samples written before it, so it can be read from and written to the history as a whole
+	struct AllPassFilterBlock {
 		float feedback = 0.0f;
-		
+
+		AllPassFilterBlock() = default;
+
+		explicit AllPassFilterBlock(int max_delay) { resize(max_delay); }
+
+		// Allocates and clears the history, not meant for the audio path
+		void resize(int max_delay) {
+			history.resize(max_delay);
+			delay = std::clamp(delay, 1, max_delay);
+		}
+
 		void set_delay(int delay_in_samples) {
-			history.resize(delay_in_samples);
-			history_offset %= history.size();
+			delay = std::clamp(delay_in_samples, 1, history.get_max_delay());
 		}
 
-		T process(T const & x) {
-			auto old = history[history_offset];
+		// Filters the given samples in place, count should be at most BLOCK_SIZE
+		void process(float * samples, int count) {
+			assert(count <= BLOCK_SIZE);
 
-			auto y = -x + old;
+			alignas(16) float old[BLOCK_SIZE];
+			alignas(16) float h  [BLOCK_SIZE];
 
-			history[history_offset] = x + feedback * old;
-			history_offset = util::wrap<int>(history_offset + 1, history.size());
+			auto g = simd::float4(feedback);
 
-			return y;
+			for (int chunk_start = 0; chunk_start < count; chunk_start += delay) {
+				auto chunk_size = std::min(delay, count - chunk_start);
+				auto x          = samples + chunk_start;
+
+				history.read(delay, old, chunk_size);
+
+				auto i = 0;
+
+				for (; i + simd::WIDTH <= chunk_size; i += simd::WIDTH) {
+					auto v = simd::float4::loadu(&x[i]);
+					auto o = simd::float4::load(&old[i]);
+
+					(o - v).storeu(&x[i]);
+					(v + g * o).store(&h[i]);
+				}
+
+				for (; i < chunk_size; i++) {
+					h[i] = x[i] + feedback * old[i];
+					x[i] = old[i] - x[i];
+				}
+
+				history.write(h, chunk_size);
+			}
 		}
+
+	private:
+		DelayLine<float> history;
+		int              delay = 1;
 	};
 }
@@ -0,0 +1,245 @@
+#pragma once
+#include <utility>
+
+#include "biquadfilter.h"
+
+#include "util/simd.h"
+
+namespace dsp {
+	// Coefficients of simd::WIDTH independent biquad sections, one per lane, in transposed direct form II
+	// The output is substituted into the state update (c1 and c2 below), so the new state does not have to wait for the output
+	struct alignas(16) BiQuadLanes {
+		float b0[simd::WIDTH] = { 1.0f, 1.0f, 1.0f, 1.0f }; // Pass through by default
+		float c1[simd::WIDTH] = { }; // b1 - a1 * b0
+		float c2[simd::WIDTH] = { }; // b2 - a2 * b0
+		float a1[simd::WIDTH] = { };
+		float a2[simd::WIDTH] = { };
+
+		void set(int lane, BiQuadCoefficients const & coefficients) {
+			b0[lane] = coefficients.b0;
+			c1[lane] = coefficients.b1 - coefficients.a1 * coefficients.b0;
+			c2[lane] = coefficients.b2 - coefficients.a2 * coefficients.b0;
+			a1[lane] = coefficients.a1;
+			a2[lane] = coefficients.a2;
+		}
+
+		void copy(int lane, BiQuadLanes const & other, int other_lane) {
+			b0[lane] = other.b0[other_lane];
+			c1[lane] = other.c1[other_lane];
+			c2[lane] = other.c2[other_lane];
+			a1[lane] = other.a1[other_lane];
+			a2[lane] = other.a2[other_lane];
+		}
+
+		// The coefficients loaded into registers, the state lives with the caller so one set of coefficients can filter several signals
+		struct Registers {
+			simd::float4 b0, c1, c2, a1, a2;
+
+			simd::float4 process(simd::float4 const & x, simd::float4 & s1, simd::float4 & s2) const {
+				auto out = b0 * x + s1;
+				auto n1  = (c1 * x + s2) - a1 * s1;
+				auto n2  =  c2 * x       - a2 * s1;
+
+				s1 = n1;
+				s2 = n2;
+
+				return out;
+			}
+		};
+
+		Registers load() const {
+			return {
+				simd::float4::load(b0),
+				simd::float4::load(c1),
+				simd::float4::load(c2),
+				simd::float4::load(a1),
+				simd::float4::load(a2)
+			};
+		}
+	};
+
+	// Stereo cascade of up to MAX_SECTIONS biquad sections (second order sections) in transposed direct form II
+	// Coefficients and state are stored per pair of sections, one SIMD register holds both channels of two neighbouring sections
+	//
+	// Every section needs the output of the previous one, so the cascade is skewed in time like a pipeline:
+	// at step t section k processes sample t - k, which makes all pairs of sections independent within a step
+	// Sections are switched off for the first and last few steps of every block (ramp up and ramp down),
+	// so the skew never crosses a block boundary and no latency is introduced
+	struct BiQuadCascade {
+		static constexpr auto MAX_SECTIONS = 32;
+
+		static_assert(MAX_SECTIONS % 2 == 0 && MAX_SECTIONS <= BLOCK_SIZE);
+
+		int get_num_sections() const { return num_sections; }
+
+		// Appends a section that passes its input through unchanged
+		void add_section() {
+			assert(num_sections < MAX_SECTIONS);
+			num_sections++;
+		}
+
+		// Inserts a section that passes its input through unchanged, later sections move up one place and keep their state
+		void insert_section(int index) {
+			assert(index >= 0 && index <= num_sections && num_sections < MAX_SECTIONS);
+
+			for (int i = num_sections; i > index; i--) copy_section(i, i - 1);
+
+			num_sections++;
+			clear_section(index);
+		}
+
+		// Later sections move down one place and keep their state
+		void remove_section(int index) {
+			assert(index >= 0 && index < num_sections);
+
+			for (int i = index; i < num_sections - 1; i++) copy_section(i, i + 1);
+
+			num_sections--;
+			clear_section(num_sections);
+		}
+
+		// Changes the coefficients of a section but keeps its state, so parameters can be changed while playing
+		void set_section(int index, BiQuadCoefficients const & coefficients) {
+			assert(index >= 0 && index < num_sections);
+
+			auto & pair = pairs[index / 2];
+			auto   lane = 2 * (index % 2);
+
+			for (int channel = 0; channel < 2; channel++) {
+				pair.coefficients.set(lane + channel, coefficients);
+			}
+		}
+
+		void reset_state() {
+			for (auto & pair : pairs) {
+				for (int lane = 0; lane < simd::WIDTH; lane++) {
+					pair.s1[lane] = 0.0f;
+					pair.s2[lane] = 0.0f;
+				}
+			}
+		}
+
+		void process(Sample const in[BLOCK_SIZE], Sample out[BLOCK_SIZE]) {
+			// An odd number of sections is padded with a pass through section
+			auto num_pairs = (num_sections + 1) / 2;
+
+			// One extra sample of room, so that the output can be written with one unaligned store per step
+			Sample buffer[BLOCK_SIZE + 1];
+			std::copy(in, in + BLOCK_SIZE, buffer);
+
+			// Pairs are processed in chunks that are small enough to keep their state in registers
+			for (int p = 0; p < num_pairs; p += PAIRS_PER_CHUNK) {
+				switch (std::min(num_pairs - p, PAIRS_PER_CHUNK)) {
+					case 1: process_chunk<1>(&pairs[p], buffer); break;
+					case 2: process_chunk<2>(&pairs[p], buffer); break;
+					case 3: process_chunk<3>(&pairs[p], buffer); break;
+					case 4: process_chunk<4>(&pairs[p], buffer); break;
+
+					default: abort();
+				}
+			}
+
+			std::copy(buffer, buffer + BLOCK_SIZE, out);
+		}
+
+	private:
+		// Lanes hold (left, right) of the even section followed by (left, right) of the odd section
+		struct Pair {
+			BiQuadLanes coefficients;
+
+			alignas(16) float s1[simd::WIDTH] = { };
+			alignas(16) float s2[simd::WIDTH] = { };
+		};
+
+		static constexpr auto PAIRS_PER_CHUNK = 4;
+
+		// Runs NUM_PAIRS pairs over the block in place
+		// Reading sample t and writing sample t - (2 * NUM_PAIRS - 1) in the same step is safe since the write always trails the read
+		template<int NUM_PAIRS>
+		static void process_chunk(Pair * pairs, Sample buffer[BLOCK_SIZE + 1]) {
+			static constexpr auto NUM_STAGES = 2 * NUM_PAIRS;
+
+			BiQuadLanes::Registers sections[NUM_PAIRS];
+
+			simd::float4 s1[NUM_PAIRS], s2[NUM_PAIRS];
+			simd::float4 y [NUM_PAIRS];
+
+			for (int p = 0; p < NUM_PAIRS; p++) {
+				sections[p] = pairs[p].coefficients.load();
+				s1[p] = simd::float4::load(pairs[p].s1);
+				s2[p] = simd::float4::load(pairs[p].s2);
+			}
+
+			for (int t = 0; t < BLOCK_SIZE + NUM_STAGES - 1; t++) {
+				auto x = t < BLOCK_SIZE ? buffer[t] : Sample(0.0f);
+
+				// Sections ramp up at the start and down at the end of the block
+				auto ramp = t < NUM_STAGES - 1 || t >= BLOCK_SIZE;
+
+				// Pairs are updated back to front, so that every pair still sees the previous step's output of the pair before it
+				// The loop over pairs is unrolled at compile time so that all state can stay in registers
+				auto update_pair = [&]<int P>() {
+					auto v = P > 0
+						? simd::concat_hi_lo(y[P > 0 ? P - 1 : 0], y[P])
+						: simd::concat_lo(simd::float4(x.left, x.right, x.left, x.right), y[P]);
+
+					auto n1  = s1[P];
+					auto n2  = s2[P];
+					auto out = sections[P].process(v, n1, n2);
+
+					if (ramp) {
+						// Section k is only active while the sample it processes, t - k, lies within the block
+						auto active = [t](int k) { return t - k >= 0 && t - k < BLOCK_SIZE; };
+						auto mask = simd::float4::from_mask_bits((active(2 * P) ? 0b0011 : 0) | (active(2 * P + 1) ? 0b1100 : 0));
+
+						n1 = simd::select(mask, n1, s1[P]);
+						n2 = simd::select(mask, n2, s2[P]);
+					}
+
+					s1[P] = n1;
+					s2[P] = n2;
+					y [P] = out;
+				};
+				[&]<int... P>(std::integer_sequence<int, P...>) {
+					(update_pair.template operator()<NUM_PAIRS - 1 - P>(), ...);
+				}(std::make_integer_sequence<int, NUM_PAIRS>());
+
+				// The last section has processed sample t - (NUM_STAGES - 1)
+				auto index = t - (NUM_STAGES - 1);
+				if (index >= 0) {
+					simd::concat_hi(y[NUM_PAIRS - 1], y[NUM_PAIRS - 1]).storeu(&buffer[index].left);
+				}
+			}
+
+			for (int p = 0; p < NUM_PAIRS; p++) {
+				s1[p].store(pairs[p].s1);
+				s2[p].store(pairs[p].s2);
+			}
+		}
+
+		Pair pairs[MAX_SECTIONS / 2];
+		int  num_sections = 0;
+
+		void copy_section(int dst, int src) {
+			auto & pair_dst = pairs[dst / 2]; auto lane_dst = 2 * (dst % 2);
+			auto & pair_src = pairs[src / 2]; auto lane_src = 2 * (src % 2);
+
+			for (int channel = 0; channel < 2; channel++) {
+				pair_dst.coefficients.copy(lane_dst + channel, pair_src.coefficients, lane_src + channel);
+				pair_dst.s1[lane_dst + channel] = pair_src.s1[lane_src + channel];
+				pair_dst.s2[lane_dst + channel] = pair_src.s2[lane_src + channel];
+			}
+		}
+
+		void clear_section(int index) {
+			auto & pair = pairs[index / 2];
+			auto   lane = 2 * (index % 2);
+
+			for (int channel = 0; channel < 2; channel++) {
+				pair.coefficients.set(lane + channel, { });
+				pair.s1[lane + channel] = 0.0f;
+				pair.s2[lane + channel] = 0.0f;
+			}
+		}
+	};
+}
@@ -13,19 +13,12 @@ namespace dsp {
 		HIGH_SHELF
 	};
 
-	// Based on: https://arachnoid.com/BiQuadDesigner/index.html
-	template<typename T>
-	struct BiQuadFilter {
-		BiQuadFilterMode mode = BiQuadFilterMode::LOW_PASS;
-
-		float b0 = 1.0f, b1 = 1.0f, b2 = 1.0f, a1 = 1.0f, a2 = 1.0f;
-
-		T x1 = { }, x2 = { };
-		T y1 = { }, y2 = { };
-
-		void set(BiQuadFilterMode mode, float frequency, float Q, float gain_db = 0.0f) {
-			this->mode = mode;
+	// Normalized so that a0 = 1, the defaults pass the input through unchanged
+	struct BiQuadCoefficients {
+		float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
 
+		// Based on: https://arachnoid.com/BiQuadDesigner/index.html
+		static BiQuadCoefficients design(BiQuadFilterMode mode, float frequency, float Q, float gain_db = 0.0f) {
 			auto omega = TWO_PI * frequency * SAMPLE_RATE_INV;
 			auto sin_omega = std::sin(omega);
 			auto cos_omega = std::cos(omega);
@@ -35,7 +28,7 @@ namespace dsp {
 			auto alpha = sin_omega / (2.0f * std::max(Q, 0.001f));
 			auto beta  = std::sqrt(2.0f * gain);
 			
-			auto a0 = 1.0f;
+			float b0, b1, b2, a0, a1, a2;
 
 			switch (mode) {
 				case BiQuadFilterMode::LOW_PASS: {
@@ -114,12 +107,29 @@ namespace dsp {
 				default: abort();
 			}
 			
-			// Normalize
-			b0 /= a0;
-			b1 /= a0;
-			b2 /= a0;
-			a1 /= a0;
-			a2 /= a0;
+			return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+		}
+	};
+
+	template<typename T>
+	struct BiQuadFilter {
+		BiQuadFilterMode mode = BiQuadFilterMode::LOW_PASS;
+
+		float b0 = 1.0f, b1 = 1.0f, b2 = 1.0f, a1 = 1.0f, a2 = 1.0f;
+
+		T x1 = { }, x2 = { };
+		T y1 = { }, y2 = { };
+
+		void set(BiQuadFilterMode mode, float frequency, float Q, float gain_db = 0.0f) {
+			this->mode = mode;
+
+			auto coefficients = BiQuadCoefficients::design(mode, frequency, Q, gain_db);
+
+			b0 = coefficients.b0;
+			b1 = coefficients.b1;
+			b2 = coefficients.b2;
+			a1 = coefficients.a1;
+			a2 = coefficients.a2;
 		}
 
 		void reset_state() {
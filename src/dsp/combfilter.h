@@ -1,32 +1,82 @@
 #pragma once
+#include <vector>
+#include <algorithm>
+
 #include "util/util.h"
+#include "util/simd.h"
 
 namespace dsp {
-	template<typename T>
-	struct CombFilter {
-		std::vector<T> history;
-		int            history_offset = 0;
+	// NUM_LINES comb filters that run in parallel, processed simd::WIDTH lines at a time
+	// The lines share one interleaved delay buffer (frame f holds sample f of every line) with a power of two number of frames,
+	// so every sample writes a single contiguous frame and all indices wrap using a mask
+	template<int NUM_LINES>
+	struct CombFilterBank {
+		static_assert(NUM_LINES % simd::WIDTH == 0);
 
-		float feedback = 0.0f;
-		float damp     = 0.0f;
+		static constexpr auto NUM_VECTORS = NUM_LINES / simd::WIDTH;
 
-	private:
-		T state = { };
+		alignas(16) float feedback[NUM_LINES] = { };
+		alignas(16) float damp    [NUM_LINES] = { };
+
+		CombFilterBank() = default;
+
+		explicit CombFilterBank(int max_delay) { resize(max_delay); }
+
+		// Allocates and clears the history, not meant for the audio path
+		void resize(int max_delay) {
+			auto size = util::next_power_of_two(max_delay + 1);
+
+			history.assign(size * NUM_LINES, 0.0f);
+			offset = 0;
+			mask   = size - 1;
 
-	public:
-		void set_delay(int delay_in_samples) {
-			history.resize(delay_in_samples);
-			history_offset %= history.size();
+			this->max_delay = max_delay;
+
+			for (int l = 0; l < NUM_LINES; l++) delays[l] = std::clamp(delays[l], 1, max_delay);
+
+			std::fill(std::begin(state), std::end(state), 0.0f);
 		}
 
-		T process(T const & x) {
-			auto y = history[history_offset];
-			state = util::lerp(y, state, damp);
+		void set_delays(int const delays_in_samples[NUM_LINES]) {
+			for (int l = 0; l < NUM_LINES; l++) delays[l] = std::clamp(delays_in_samples[l], 1, max_delay);
+		}
+
+		int get_delay(int line) const { return delays[line]; }
+
+		// Feeds x into the lines and returns their outputs in y, line l is lane l % simd::WIDTH of vector l / simd::WIDTH
+		void process(simd::float4 const x[NUM_VECTORS], simd::float4 y[NUM_VECTORS]) {
+			alignas(16) float delayed[NUM_LINES];
 
-			history[history_offset] = x + feedback * state;
-			history_offset = util::wrap<int>(history_offset + 1, history.size());
+			// Gather, every line reads at its own delay
+			for (int l = 0; l < NUM_LINES; l++) {
+				delayed[l] = history[((offset - delays[l]) & mask) * NUM_LINES + l];
+			}
 
-			return y;
+			auto frame = &history[offset * NUM_LINES];
+
+			for (int v = 0; v < NUM_VECTORS; v++) {
+				auto out = simd::float4::load(&delayed[v * simd::WIDTH]);
+
+				auto s = simd::lerp(out, simd::float4::load(&state[v * simd::WIDTH]), simd::float4::load(&damp[v * simd::WIDTH]));
+				s.store(&state[v * simd::WIDTH]);
+
+				(x[v] + simd::float4::load(&feedback[v * simd::WIDTH]) * s).storeu(&frame[v * simd::WIDTH]);
+
+				y[v] = out;
+			}
+
+			offset = (offset + 1) & mask;
 		}
+
+	private:
+		std::vector<float> history;
+		int                offset = 0;
+		int                mask   = 0;
+
+		int max_delay = 0;
+
+		int delays[NUM_LINES] = { };
+
+		alignas(16) float state[NUM_LINES] = { }; // Low pass filtered output of every line
 	};
 }
@@ -0,0 +1,181 @@
+#include "convolver.h"
+
+#include <algorithm>
+
+#include "fft.h"
+
+template<int PARTITION_SIZE>
+void dsp::Convolver::Segment<PARTITION_SIZE>::init(Sample const * impulse_response, int length, bool is_mono) {
+	num_partitions = (length + PARTITION_SIZE - 1) / PARTITION_SIZE;
+
+	sum .resize(num_partitions * FFT_SIZE);
+	diff.resize(is_mono ? 0 : num_partitions * FFT_SIZE);
+
+	history.resize(num_partitions * FFT_SIZE);
+
+	std::vector<Sample> spectrum(FFT_SIZE);
+
+	for (int p = 0; p < num_partitions; p++) {
+		auto first = p * PARTITION_SIZE;
+		auto count = std::min(PARTITION_SIZE, length - first);
+
+		// Zero padded to twice the partition size, the left channel goes in the real part and the right channel in the imaginary part
+		std::fill(spectrum.begin(), spectrum.end(), Sample(0.0f, 0.0f));
+		std::copy(impulse_response + first, impulse_response + first + count, spectrum.begin());
+
+		fft<FFT_SIZE>(spectrum.data());
+
+		for (int k = 0; k < FFT_SIZE; k++) {
+			auto z        = spectrum[k];
+			auto z_mirror = complex_conj(spectrum[(FFT_SIZE - k) & (FFT_SIZE - 1)]);
+
+			// Separate the spectra of the two real channels
+			auto h_left  = 0.5f * (z + z_mirror);
+			auto h_right = complex_mul(0.5f * (z - z_mirror), Sample(0.0f, -1.0f));
+
+			sum[p * FFT_SIZE + k] = 0.5f * (h_left + h_right);
+
+			if (!is_mono) diff[p * FFT_SIZE + k] = 0.5f * (h_left - h_right);
+		}
+	}
+}
+
+template<int PARTITION_SIZE>
+void dsp::Convolver::Segment<PARTITION_SIZE>::push_input(Sample const * samples) {
+	std::copy(window.begin() + PARTITION_SIZE, window.end(), window.begin());
+	std::copy(samples, samples + PARTITION_SIZE, window.begin() + PARTITION_SIZE);
+}
+
+template<int PARTITION_SIZE>
+void dsp::Convolver::Segment<PARTITION_SIZE>::convolve() {
+	auto spectrum = &history[history_offset * FFT_SIZE];
+
+	std::copy(window.begin(), window.end(), spectrum);
+	fft<FFT_SIZE>(spectrum);
+
+	std::fill(output.begin(), output.end(), Sample(0.0f, 0.0f));
+
+	for (int p = 0; p < num_partitions; p++) {
+		// Partition p is applied to the input from p partitions ago
+		auto x = &history[((history_offset - p + num_partitions) % num_partitions) * FFT_SIZE];
+
+		auto h_sum = &sum[p * FFT_SIZE];
+
+		for (int k = 0; k < FFT_SIZE; k++) {
+			output[k] += complex_mul(x[k], h_sum[k]);
+		}
+
+		if (diff.empty()) continue;
+
+		auto h_diff = &diff[p * FFT_SIZE];
+
+		for (int k = 0; k < FFT_SIZE; k++) {
+			output[k] += complex_mul(complex_conj(x[(FFT_SIZE - k) & (FFT_SIZE - 1)]), h_diff[k]);
+		}
+	}
+
+	ifft<FFT_SIZE>(output.data());
+
+	history_offset = (history_offset + 1) % num_partitions;
+}
+
+dsp::Convolver::Convolver(std::vector<Sample> const & impulse_response) {
+	length = std::min(int(impulse_response.size()), MAX_LENGTH);
+	assert(length > 0);
+
+	auto is_mono = std::all_of(impulse_response.begin(), impulse_response.begin() + length, [](Sample const & sample) {
+		return sample.left == sample.right;
+	});
+
+	head.init(impulse_response.data(), std::min(length, HEAD_LENGTH), is_mono);
+
+	if (length > HEAD_LENGTH) {
+		tail.init(impulse_response.data() + HEAD_LENGTH, length - HEAD_LENGTH, is_mono);
+
+		worker = std::thread(&Convolver::worker_loop, this);
+	}
+}
+
+dsp::Convolver::~Convolver() {
+	if (!worker.joinable()) return;
+
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+
+	worker.join();
+}
+
+void dsp::Convolver::process(Sample const * in, Sample * out) {
+	head.push_input(in);
+	head.convolve();
+
+	std::copy(head.output.begin() + HEAD_SIZE, head.output.end(), out);
+
+	if (tail.num_partitions == 0) return;
+
+	static constexpr auto BLOCKS_PER_JOB = TAIL_SIZE / BLOCK_SIZE;
+	static_assert(HEAD_LENGTH == 2 * TAIL_SIZE);
+
+	// The job that was submitted two tail partitions ago covers the current block
+	auto job = jobs_submitted - 2;
+
+	if (job >= 0) {
+		wait_for_job(job);
+
+		auto const & tail_output = tail_outputs[job % 2];
+
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			out[i] += tail_output[tail_input_blocks * BLOCK_SIZE + i];
+		}
+	}
+
+	std::copy(in, in + BLOCK_SIZE, tail_input.begin() + tail_input_blocks * BLOCK_SIZE);
+
+	if (++tail_input_blocks < BLOCKS_PER_JOB) return;
+
+	tail_input_blocks = 0;
+
+	// The worker is idle once the previous job has finished, after which the tail can be touched
+	wait_for_job(jobs_submitted - 1);
+
+	tail.push_input(tail_input.data());
+
+	{
+		std::lock_guard lock(mutex);
+		jobs_submitted++;
+	}
+	condition.notify_all();
+}
+
+void dsp::Convolver::worker_loop() {
+	while (true) {
+		int job;
+
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [this]() { return stopping || jobs_finished < jobs_submitted; });
+
+			if (stopping) return;
+
+			job = jobs_finished;
+		}
+
+		tail.convolve();
+
+		std::copy(tail.output.begin() + TAIL_SIZE, tail.output.end(), tail_outputs[job % 2].begin());
+
+		{
+			std::lock_guard lock(mutex);
+			jobs_finished++;
+		}
+		condition.notify_all();
+	}
+}
+
+void dsp::Convolver::wait_for_job(int job) {
+	std::unique_lock lock(mutex);
+	condition.wait(lock, [this, job]() { return jobs_finished > job; });
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "synth/sample.h"
+
+namespace dsp {
+	// Zero latency stereo convolution with an impulse response, using non-uniformly partitioned overlap-save FFT convolution
+	//
+	// The impulse response is split in two segments:
+	//  - The head, the first HEAD_LENGTH samples, is cut into partitions of BLOCK_SIZE samples that are convolved
+	//    in the audio block itself. Since the partitions are as large as a block no extra latency is introduced
+	//  - The tail, everything after the head, is cut into partitions of TAIL_SIZE samples that are convolved on a background thread
+	//    A tail job starts once TAIL_SIZE input samples have been gathered, its output is first needed HEAD_LENGTH - TAIL_SIZE samples later,
+	//    so the worker has TAIL_SIZE samples (TAIL_SIZE / BLOCK_SIZE blocks) worth of time to finish it
+	//
+	// Cost: the head costs two FFTs of 2 * BLOCK_SIZE points plus one complex multiply-add per bin per head partition every block,
+	// which is bounded because the head never has more than HEAD_LENGTH / BLOCK_SIZE partitions
+	// The tail costs two FFTs of 2 * TAIL_SIZE points plus one multiply-add per bin per tail partition every TAIL_SIZE samples,
+	// so its cost per sample grows linearly with the length of the impulse response but is spent off the audio thread
+	// Stereo impulse responses cost twice as much per multiply-add as mono ones
+	//
+	// The left and right channel are packed into the real and imaginary part of a single complex FFT,
+	// a stereo impulse response is applied as X * (H_l + H_r) / 2 + conj(X mirrored) * (H_l - H_r) / 2
+	struct Convolver {
+		static constexpr auto HEAD_SIZE   = BLOCK_SIZE;     // Partition size of the head
+		static constexpr auto TAIL_SIZE   = 8 * BLOCK_SIZE; // Partition size of the tail
+		static constexpr auto HEAD_LENGTH = 2 * TAIL_SIZE;  // Number of samples of the impulse response covered by the head
+
+		static constexpr auto MAX_LENGTH = 10 * SAMPLE_RATE; // Longer impulse responses are truncated
+
+		Convolver(std::vector<Sample> const & impulse_response);
+		~Convolver();
+
+		Convolver(Convolver const &) = delete;
+		Convolver & operator=(Convolver const &) = delete;
+
+		int get_length() const { return length; }
+
+		// Convolves one block of BLOCK_SIZE samples, may wait for the background thread if it has fallen behind
+		void process(Sample const * in, Sample * out);
+
+	private:
+		// Spectra of the zero padded partitions of one segment of the impulse response
+		template<int PARTITION_SIZE>
+		struct Segment {
+			static constexpr auto FFT_SIZE = 2 * PARTITION_SIZE;
+
+			int num_partitions = 0;
+
+			std::vector<Sample> sum;  // (H_l + H_r) / 2 per partition, as complex numbers
+			std::vector<Sample> diff; // (H_l - H_r) / 2 per partition, empty if the impulse response is mono
+
+			std::vector<Sample> history; // Spectra of the last num_partitions input windows (frequency domain delay line)
+			int                 history_offset = 0;
+
+			std::vector<Sample> window = std::vector<Sample>(FFT_SIZE); // Previous input partition followed by the current one
+			std::vector<Sample> output = std::vector<Sample>(FFT_SIZE); // The last PARTITION_SIZE samples are valid
+
+			void init(Sample const * impulse_response, int length, bool is_mono);
+
+			void push_input(Sample const * samples);
+
+			// Transforms the window and convolves it with all partitions
+			void convolve();
+		};
+
+		int length;
+
+		Segment<HEAD_SIZE> head;
+		Segment<TAIL_SIZE> tail;
+
+		std::vector<Sample> tail_input = std::vector<Sample>(TAIL_SIZE); // Input gathered for the next tail job
+		int                 tail_input_blocks = 0;
+
+		// Double buffered output of the tail jobs, written by the worker and read by the audio thread
+		std::vector<Sample> tail_outputs[2] = { std::vector<Sample>(TAIL_SIZE), std::vector<Sample>(TAIL_SIZE) };
+
+		std::thread             worker;
+		std::mutex              mutex;
+		std::condition_variable condition;
+
+		int  jobs_submitted = 0;
+		int  jobs_finished  = 0;
+		bool stopping       = false;
+
+		void worker_loop();
+
+		void wait_for_job(int job); // Waits until the given job (and all before it) has finished
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <utility>
+
+#include "biquad_cascade.h"
+
+#include "util/simd.h"
+
+namespace dsp {
+	// Splits a stereo signal into up to MAX_BANDS bands with fourth order Linkwitz-Riley crossovers (24 dB per octave),
+	// two Butterworth sections in series per low or high pass. The bands sum back to an all pass of the input
+	//
+	// Instead of a tree of splits every band runs its own chain of two sections per crossover: high pass for the crossovers below the band,
+	// low pass for the crossover above it and the all pass that low and high pass sum to for the crossovers further up,
+	// which keeps the bands in phase with each other. All chains have the same length, so the bands are processed side by side in SIMD,
+	// one register holds (left, right) of two neighbouring bands like in dsp::BiQuadCascade
+	struct Crossover {
+		static constexpr auto MAX_BANDS = 6;
+		static constexpr auto MAX_PAIRS = MAX_BANDS / 2;
+
+		int get_num_bands() const { return num_bands; }
+		int get_num_pairs() const { return (num_bands + 1) / 2; }
+
+		// Frequencies of the num_bands - 1 crossovers, the state is only reset when the number of bands changes
+		void set_crossovers(float const freqs[], int num_bands) {
+			assert(num_bands >= 2 && num_bands <= MAX_BANDS);
+
+			if (num_bands != this->num_bands) {
+				this->num_bands = num_bands;
+				reset_state();
+			}
+
+			auto Q = std::sqrt(0.5f);
+
+			for (int band = 0; band < 2 * get_num_pairs(); band++) {
+				for (int c = 0; c < num_bands - 1; c++) {
+					BiQuadCoefficients first, second; // Pass through by default
+
+					if (band >= num_bands) {
+						// Padding lanes output nothing
+						if (c == 0) first = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+					} else if (c < band) {
+						first = second = BiQuadCoefficients::design(BiQuadFilterMode::HIGH_PASS, freqs[c], Q);
+					} else if (c == band) {
+						first = second = BiQuadCoefficients::design(BiQuadFilterMode::LOW_PASS,  freqs[c], Q);
+					} else {
+						first = BiQuadCoefficients::design(BiQuadFilterMode::ALL_PASS, freqs[c], Q);
+					}
+
+					set_section(band, 2 * c,     first);
+					set_section(band, 2 * c + 1, second);
+				}
+			}
+		}
+
+		void reset_state() {
+			for (auto & pair : pairs) {
+				for (auto & section : pair.sections) {
+					for (int lane = 0; lane < simd::WIDTH; lane++) {
+						section.s1[lane] = 0.0f;
+						section.s2[lane] = 0.0f;
+					}
+				}
+			}
+		}
+
+		// Lanes of out[i][p] hold (left, right) of band 2p followed by (left, right) of band 2p + 1 at sample i
+		void process(Sample const in[BLOCK_SIZE], simd::float4 out[BLOCK_SIZE][MAX_PAIRS]) {
+			switch (num_bands) {
+				case 2: process_bands<1, 2 >(in, out); break;
+				case 3: process_bands<2, 4 >(in, out); break;
+				case 4: process_bands<2, 6 >(in, out); break;
+				case 5: process_bands<3, 8 >(in, out); break;
+				case 6: process_bands<3, 10>(in, out); break;
+
+				default: abort();
+			}
+		}
+
+	private:
+		static constexpr auto MAX_SECTIONS = 2 * (MAX_BANDS - 1);
+
+		struct Section {
+			BiQuadLanes coefficients;
+
+			alignas(16) float s1[simd::WIDTH] = { };
+			alignas(16) float s2[simd::WIDTH] = { };
+		};
+
+		struct Pair {
+			Section sections[MAX_SECTIONS];
+		};
+
+		Pair pairs[MAX_PAIRS];
+		int  num_bands = 0;
+
+		void set_section(int band, int index, BiQuadCoefficients const & coefficients) {
+			auto & section = pairs[band / 2].sections[index];
+			auto   lane    = 2 * (band % 2);
+
+			for (int channel = 0; channel < 2; channel++) {
+				section.coefficients.set(lane + channel, coefficients);
+			}
+		}
+
+		// The chains of all pairs are advanced together one sample at a time, so that they form independent dependency chains
+		template<int NUM_PAIRS, int NUM_SECTIONS>
+		void process_bands(Sample const in[BLOCK_SIZE], simd::float4 out[BLOCK_SIZE][MAX_PAIRS]) {
+			simd::float4 s1[NUM_PAIRS][NUM_SECTIONS];
+			simd::float4 s2[NUM_PAIRS][NUM_SECTIONS];
+
+			for (int p = 0; p < NUM_PAIRS; p++) {
+				for (int s = 0; s < NUM_SECTIONS; s++) {
+					s1[p][s] = simd::float4::load(pairs[p].sections[s].s1);
+					s2[p][s] = simd::float4::load(pairs[p].sections[s].s2);
+				}
+			}
+
+			for (int i = 0; i < BLOCK_SIZE; i++) {
+				auto x = simd::float4(in[i].left, in[i].right, in[i].left, in[i].right);
+
+				for (int p = 0; p < NUM_PAIRS; p++) {
+					auto v = x;
+
+					for (int s = 0; s < NUM_SECTIONS; s++) {
+						v = pairs[p].sections[s].coefficients.load().process(v, s1[p][s], s2[p][s]);
+					}
+
+					out[i][p] = v;
+				}
+			}
+
+			for (int p = 0; p < NUM_PAIRS; p++) {
+				for (int s = 0; s < NUM_SECTIONS; s++) {
+					s1[p][s].store(pairs[p].sections[s].s1);
+					s2[p][s].store(pairs[p].sections[s].s2);
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+#include "interpolation.h"
+
+#include "util/util.h"
+
+namespace dsp {
+	// Circular history of the most recently written samples with a power of two size, so that all indices wrap using a mask
+	// The buffer is sized for a declared maximum delay when the line is created, changing the delay while playing never allocates
+	//
+	// A delay of d reads the sample that was written d writes ago, so a delay of 1 reads the most recently written sample
+	template<typename T>
+	struct DelayLine {
+		DelayLine() = default;
+
+		explicit DelayLine(int max_delay) { resize(max_delay); }
+
+		// Allocates room for delays up to max_delay (plus the frames needed for cubic interpolation) and clears the history
+		// Not meant for the audio path, lines should be created with the largest delay they will need
+		void resize(int max_delay) {
+			auto size = util::next_power_of_two(max_delay + 3);
+
+			buffer.assign(size, T { });
+			mask     = size - 1;
+			position = 0;
+
+			this->max_delay = max_delay;
+		}
+
+		int get_max_delay() const { return max_delay; }
+
+		void clear() {
+			std::fill(buffer.begin(), buffer.end(), T { });
+		}
+
+		void write(T const & sample) {
+			buffer[position] = sample;
+			position = (position + 1) & mask;
+		}
+
+		// Writes count samples at once
+		void write(T const samples[], int count) {
+			assert(count <= mask + 1);
+
+			auto first = std::min(count, mask + 1 - position); // Samples before the end of the buffer
+
+			std::copy(samples,         samples + first, buffer.begin() + position);
+			std::copy(samples + first, samples + count, buffer.begin());
+
+			position = (position + count) & mask;
+		}
+
+		T const & read(int delay) const {
+			assert(delay >= 1 && delay <= max_delay + 2);
+			return buffer[(position - delay) & mask];
+		}
+
+		// Reads the samples that the next count writes would see at the given delay, which have all been written already if count <= delay
+		void read(int delay, T out[], int count) const {
+			assert(delay >= 1 && delay <= max_delay && count <= delay);
+
+			auto start = (position - delay) & mask;
+			auto first = std::min(count, mask + 1 - start);
+
+			std::copy(buffer.begin() + start, buffer.begin() + start + first, out);
+			std::copy(buffer.begin(),         buffer.begin() + count - first, out + first);
+		}
+
+		// Fractional delay, at least 1
+		T read_linear(float delay) const {
+			auto index = int(delay);
+			auto t     = delay - float(index);
+
+			return util::lerp(read(index), read(index + 1), t);
+		}
+
+		// Fractional delay, at least 2 so that the newer neighbour of the interpolated pair exists
+		T read_cubic(float delay) const {
+			auto index = int(delay);
+			auto t     = delay - float(index);
+
+			T frames[4] = { read(index - 1), read(index), read(index + 1), read(index + 2) };
+			return interpolate_cubic(frames, t);
+		}
+
+		// Fractional delay of at least 1 through a first order all pass, which has a flat magnitude response unlike linear interpolation
+		// The all pass has a state of its own, so a tap has to be read exactly once for every sample written
+		T read_allpass(float delay, T & state) const {
+			auto index = int(delay);
+			auto t     = delay - float(index);
+
+			auto eta = (1.0f - t) / (1.0f + t);
+
+			state = eta * (read(index) - state) + read(index + 1);
+			return state;
+		}
+
+	private:
+		std::vector<T> buffer;
+
+		int mask      = 0;
+		int position  = 0; // Where the next sample is written
+		int max_delay = 0;
+	};
+}
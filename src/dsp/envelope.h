@@ -0,0 +1,67 @@
+#pragma once
+#include "util/util.h"
+
+namespace dsp {
+	// Attack, Hold, Decay, Sustain envelope with a linear Release
+	// Rather than evaluating the envelope for every sample, the segment boundaries are converted
+	// to sample indices once per block, after which each segment is filled with a linear ramp
+	struct Envelope {
+		float attack  = 0.0f; // All times are in samples
+		float hold    = INFINITY;
+		float decay   = 0.0f;
+		float sustain = 1.0f;
+		float release = 0.0f;
+
+		static Envelope from_steps(float attack, float hold, float decay, float sustain, float release, float samples_per_step) {
+			return { attack * samples_per_step, hold * samples_per_step, decay * samples_per_step, sustain, release * samples_per_step };
+		}
+
+		// Fills amplitudes[i * stride] for i in [first, last)
+		// Envelope time is given at sample first and advances by rate every sample, release_time is INFINITY while the note is held
+		// Returns the index of the first sample after the envelope has finished, or last if it has not finished yet
+		int fill(float * amplitudes, int first, int last, float time, float rate, float release_time, float scale = 1.0f, int stride = 1) const {
+			// Index of the first sample at or after the given envelope time
+			auto to_index = [=](float t) {
+				return first + int(util::clamp(std::ceil((t - time) / rate), 0.0f, float(last - first)));
+			};
+
+			// Fills [from, to) with value(t) = value + slope * (t - t0)
+			auto ramp = [=](int from, int to, float t0, float value, float slope) {
+				auto offset    = scale * (value + slope * (time + float(from - first) * rate - t0));
+				auto increment = scale * slope * rate;
+
+				for (int i = from; i < to; i++) {
+					amplitudes[i * stride] = offset + increment * float(i - from);
+				}
+			};
+
+			auto end_attack = attack;
+			auto end_hold   = attack + hold;
+			auto end_decay  = attack + hold + decay;
+
+			auto index_attack = to_index(end_attack);
+			auto index_hold   = to_index(end_hold);
+			auto index_decay  = to_index(end_decay);
+
+			if (first        < index_attack) ramp(first,        index_attack, 0.0f,       0.0f, 1.0f / attack);
+			if (index_attack < index_hold)   ramp(index_attack, index_hold,   end_attack, 1.0f, 0.0f);
+			if (index_hold   < index_decay)  ramp(index_hold,   index_decay,  end_hold,   1.0f, (sustain - 1.0f) / decay);
+			if (index_decay  < last)         ramp(index_decay,  last,         end_decay,  sustain, 0.0f);
+
+			if (std::isinf(release_time)) return last;
+
+			// Fade out linearly over the release time
+			auto index_release = to_index(release_time);
+			auto index_done    = to_index(release_time + release);
+
+			auto gain      = 1.0f - (time + float(index_release - first) * rate - release_time) / release;
+			auto increment = -rate / release;
+
+			for (int i = index_release; i < index_done; i++) {
+				amplitudes[i * stride] *= gain + increment * float(i - index_release);
+			}
+
+			return index_done;
+		}
+	};
+}
@@ -1,60 +1,259 @@
 #pragma once
+#include <cmath>
+#include <algorithm>
+
+#include <vector>
+#include <utility>
 
 #include "synth/sample.h"
+
 #include "util/util.h"
+#include "util/simd.h"
 
 namespace dsp {
-	// Based on: https://gist.github.com/agrafix/aa49c17cd32c8ba63b6a7cb8dce8b0bd
-	template<int N, typename T>
-	void fft(T fourier[]) {
-		static_assert(util::is_power_of_two(N), "FFT can only handle N that are a power of two");
+	// Sample doubles as a complex number, left is the real part and right the imaginary part
+	inline Sample complex_mul(Sample const & a, Sample const & b) {
+		return Sample(a.left * b.left - a.right * b.right, a.left * b.right + a.right * b.left);
+	}
+
+	inline Sample complex_conj(Sample const & a) {
+		return Sample(a.left, -a.right);
+	}
+
+	// Complex FFT of N points, everything that only depends on N (the bit reversal permutation and the twiddle factors) is computed once and shared
+	// The transform is a decimation in time FFT built from radix-4 butterflies that process two complex numbers per SIMD register,
+	// if log2(N) is odd a single radix-2 stage comes first
+	template<int N>
+	struct FFTPlan {
+		static_assert(N >= 4 && util::is_power_of_two(N), "FFT can only handle N that are a power of two");
+
+		static FFTPlan const & get() {
+			static FFTPlan const plan;
+			return plan;
+		}
+
+		void forward(Sample data[]) const { transform<false>(data); }
+
+		// Scaled by 1 / N, so that the inverse undoes the forward transform
+		void inverse(Sample data[]) const {
+			transform<true>(data);
+
+			auto values = reinterpret_cast<float *>(data);
+			auto scale  = simd::float4(1.0f / float(N));
+
+			for (int i = 0; i < 2 * N; i += simd::WIDTH) {
+				(simd::float4::loadu(values + i) * scale).storeu(values + i);
+			}
+		}
+
+	private:
+		static constexpr auto LOG2_N = util::log2(N);
+
+		// Span of the first radix-4 stage, spans of 1 are special cased because their only twiddle factor is -i
+		static constexpr auto FIRST_SPAN = (LOG2_N & 1) ? 2 : 4;
+
+		std::vector<std::pair<int, int>> swaps; // Index pairs exchanged by the bit reversal permutation
 
-		// Reverse bits
-		auto i2 = N / 2;
-		auto j = 0;
-		for (int i = 0; i < N - 1; i++) {
-			if (i < j) {
-				std::swap(fourier[i], fourier[j]);
+		// For every radix-4 stage and every two neighbouring butterflies the twiddle factors of both radix-2 halves,
+		// stored as (re, re) and (-im, im) per complex number so that a complex multiply needs no shuffles of the twiddles
+		std::vector<simd::float4> twiddles;
+
+		FFTPlan() {
+			for (int i = 0; i < N; i++) {
+				auto j = 0;
+				for (int b = 0; b < LOG2_N; b++) {
+					if (i & (1 << b)) j |= 1 << (LOG2_N - 1 - b);
+				}
+				if (i < j) swaps.emplace_back(i, j);
 			}
 
-			auto k = i2;
-			while (k <= j) {
-				j -= k;
-				k /= 2;
+			for (int m = FIRST_SPAN; 4 * m <= N; m *= 4) {
+				for (int j = 0; j < m; j += 2) {
+					auto twiddle = [](int k, int n) {
+						auto angle = -2.0 * 3.14159265358979323846 * double(k) / double(n);
+						return std::make_pair(float(std::cos(angle)), float(std::sin(angle)));
+					};
+
+					auto [w2_re_0, w2_im_0] = twiddle(j,     2 * m);
+					auto [w2_re_1, w2_im_1] = twiddle(j + 1, 2 * m);
+					auto [w4_re_0, w4_im_0] = twiddle(j,     4 * m);
+					auto [w4_re_1, w4_im_1] = twiddle(j + 1, 4 * m);
+
+					twiddles.emplace_back( w2_re_0, w2_re_0,  w2_re_1, w2_re_1);
+					twiddles.emplace_back(-w2_im_0, w2_im_0, -w2_im_1, w2_im_1);
+					twiddles.emplace_back( w4_re_0, w4_re_0,  w4_re_1, w4_re_1);
+					twiddles.emplace_back(-w4_im_0, w4_im_0, -w4_im_1, w4_im_1);
+				}
 			}
-			j += k;
 		}
 
-		// Fourier Transform
-		auto c  = Sample(-1.0f, 0.0f);
-		auto l2 = 1;
+		// Multiplies two interleaved complex numbers by two twiddle factors
+		static simd::float4 mul(simd::float4 const & a, simd::float4 const & w_re, simd::float4 const & w_im) {
+			return a * w_re + simd::swap_pairs(a) * w_im;
+		}
+
+		template<bool INVERSE>
+		void transform(Sample data[]) const {
+			for (auto [i, j] : swaps) std::swap(data[i], data[j]);
+
+			auto values = reinterpret_cast<float *>(data); // Every float4 holds two complex numbers
+
+			// Multiplying by -i (forward) or i (inverse) swaps the real and imaginary part and negates one of them
+			auto const rotate = INVERSE ? simd::float4(-1.0f, 1.0f, -1.0f, 1.0f) : simd::float4(1.0f, -1.0f, 1.0f, -1.0f);
 
-		for (int l = 0; l < util::log2(N); l++) {
-			auto l1 = l2;
-			l2 <<= 1;
-			auto u1 = 1.0f;
-			auto u2 = 0.0f;
+			if constexpr (LOG2_N & 1) {
+				// Radix-2 stage with span 1, which needs no twiddle factors
+				for (int i = 0; i < 2 * N; i += 2 * simd::WIDTH) {
+					auto v0 = simd::float4::loadu(values + i);
+					auto v1 = simd::float4::loadu(values + i + simd::WIDTH);
 
-			for (j = 0; j < l1; j++) {
-				for (int i = j; i < N; i += l2) {
-					auto i1 = i + l1;
+					auto a0 = simd::concat_lo(v0, v1);
+					auto a1 = simd::concat_hi(v0, v1);
 
-					auto t1 = u1 * fourier[i1].left  - u2 * fourier[i1].right;
-					auto t2 = u1 * fourier[i1].right + u2 * fourier[i1].left;
+					auto sum  = a0 + a1;
+					auto diff = a0 - a1;
 
-					fourier[i1].left  = fourier[i].left  - t1;
-					fourier[i1].right = fourier[i].right - t2;
-					fourier[i].left  += t1;
-					fourier[i].right += t2;
+					simd::concat_lo(sum, diff).storeu(values + i);
+					simd::concat_hi(sum, diff).storeu(values + i + simd::WIDTH);
 				}
+			} else {
+				// Radix-4 stage with span 1, only the fourth input of every butterfly is multiplied by -i (or i)
+				auto const upper = simd::float4::from_mask_bits(0b1100);
 
-				auto z = u1 * c.left  - u2 * c.right;
-				u2     = u1 * c.right + u2 * c.left;
-				u1     = z;
+				for (int i = 0; i < 2 * N; i += 2 * simd::WIDTH) {
+					auto v0 = simd::float4::loadu(values + i);
+					auto v1 = simd::float4::loadu(values + i + simd::WIDTH);
+
+					auto a02 = simd::concat_lo(v0, v1);
+					auto a13 = simd::concat_hi(v0, v1);
+
+					auto b02 = a02 + a13;
+					auto b13 = a02 - a13;
+
+					auto b01 = simd::concat_lo(b02, b13);
+					auto b23 = simd::concat_hi(b02, b13);
+
+					b23 = simd::select(upper, simd::swap_pairs(b23) * rotate, b23);
+
+					(b01 + b23).storeu(values + i);
+					(b01 - b23).storeu(values + i + simd::WIDTH);
+				}
 			}
 
-			c.right = -std::sqrt(0.5f - 0.5f * c.left);
-			c.left  =  std::sqrt(0.5f + 0.5f * c.left);
+			auto twiddle = twiddles.data();
+
+			for (int m = FIRST_SPAN; 4 * m <= N; m *= 4) {
+				for (int group = 0; group < N; group += 4 * m) {
+					auto w = twiddle;
+
+					for (int j = 0; j < m; j += 2, w += 4) {
+						auto x0 = values + 2 * (group + j);
+						auto x1 = x0 + 2 * m;
+						auto x2 = x0 + 4 * m;
+						auto x3 = x0 + 6 * m;
+
+						auto w2_re = w[0];
+						auto w2_im = INVERSE ? -w[1] : w[1];
+						auto w4_re = w[2];
+						auto w4_im = INVERSE ? -w[3] : w[3];
+
+						auto a0 = simd::float4::loadu(x0);
+						auto a1 = mul(simd::float4::loadu(x1), w2_re, w2_im);
+						auto a2 = simd::float4::loadu(x2);
+						auto a3 = mul(simd::float4::loadu(x3), w2_re, w2_im);
+
+						// First radix-2 pass over span m
+						auto b0 = a0 + a1;
+						auto b1 = a0 - a1;
+						auto b2 = mul(a2 + a3, w4_re, w4_im);
+						auto b3 = simd::swap_pairs(mul(a2 - a3, w4_re, w4_im)) * rotate;
+
+						// Second radix-2 pass over span 2m
+						(b0 + b2).storeu(x0);
+						(b1 + b3).storeu(x1);
+						(b0 - b2).storeu(x2);
+						(b1 - b3).storeu(x3);
+					}
+				}
+
+				twiddle += 2 * m;
+			}
 		}
-	}
+	};
+
+	// FFT of N real values, computed as a complex FFT of N / 2 points with the even samples in the real parts and the odd samples in the imaginary parts
+	// Only the N / 2 + 1 bins from DC up to and including Nyquist are stored, the other bins are their complex conjugates
+	template<int N>
+	struct RealFFTPlan {
+		static RealFFTPlan const & get() {
+			static RealFFTPlan const plan;
+			return plan;
+		}
+
+		// Transforms N real values into N / 2 + 1 bins
+		void forward(float const input[], Sample output[]) const {
+			std::copy(input, input + N, reinterpret_cast<float *>(output)); // Packs pairs of real values into complex numbers
+
+			FFTPlan<M>::get().forward(output);
+
+			auto z0 = output[0];
+			output[0] = Sample(z0.left + z0.right, 0.0f);
+			output[M] = Sample(z0.left - z0.right, 0.0f);
+
+			// Separate the spectra of the even and odd samples and combine them, bins k and M - k are computed from the same two values
+			for (int k = 1; k <= M / 2; k++) {
+				auto a = output[k];
+				auto b = complex_conj(output[M - k]);
+
+				auto even = 0.5f * (a + b);
+				auto odd  = complex_mul(twiddles[k], Sample(0.5f * (a.right - b.right), 0.5f * (b.left - a.left)));
+
+				output[k]     = even + odd;
+				output[M - k] = complex_conj(even - odd);
+			}
+		}
+
+		// Transforms N / 2 + 1 bins back into N real values, scaled by 1 / N so that it undoes the forward transform
+		// The imaginary parts of the DC and Nyquist bins are ignored, input and output may not overlap
+		void inverse(Sample const input[], float output[]) const {
+			auto z = reinterpret_cast<Sample *>(output);
+
+			auto dc      = input[0].left;
+			auto nyquist = input[M].left;
+			z[0] = Sample(0.5f * (dc + nyquist), 0.5f * (dc - nyquist));
+
+			for (int k = 1; k <= M / 2; k++) {
+				auto a = input[k];
+				auto b = complex_conj(input[M - k]);
+
+				auto even = 0.5f * (a + b);
+				auto odd  = complex_mul(complex_conj(twiddles[k]), 0.5f * (a - b));
+
+				z[k]     = even + Sample(-odd.right, odd.left);
+				z[M - k] = complex_conj(even) + Sample(odd.right, odd.left);
+			}
+
+			FFTPlan<M>::get().inverse(z);
+		}
+
+	private:
+		static constexpr auto M = N / 2;
+
+		std::vector<Sample> twiddles; // e^(-2 pi i k / N) for k in [0, N / 4]
+
+		RealFFTPlan() : twiddles(M / 2 + 1) {
+			for (int k = 0; k <= M / 2; k++) {
+				auto angle = -2.0 * 3.14159265358979323846 * double(k) / double(N);
+				twiddles[k] = Sample(float(std::cos(angle)), float(std::sin(angle)));
+			}
+		}
+	};
+
+	// In place complex FFT
+	template<int N> void fft (Sample data[]) { FFTPlan<N>::get().forward(data); }
+	template<int N> void ifft(Sample data[]) { FFTPlan<N>::get().inverse(data); }
+
+	// Real FFT, N real values to N / 2 + 1 bins and back
+	template<int N> void rfft (float  const input[], Sample output[]) { RealFFTPlan<N>::get().forward(input, output); }
+	template<int N> void irfft(Sample const input[], float  output[]) { RealFFTPlan<N>::get().inverse(input, output); }
 }
@@ -0,0 +1,112 @@
+#pragma once
+#include "biquad_cascade.h"
+
+#include "util/simd.h"
+
+namespace dsp {
+	// Bank of up to MAX_BANDS parallel band pass filters for vocoding, every band filters both the modulator and the carrier
+	// The carrier of every band is scaled by an envelope that follows the modulator of that band, the bands are summed into the output
+	//
+	// Bands are processed in groups of simd::WIDTH, one lane per band and one register per channel,
+	// so a group runs its four filters (modulator and carrier, left and right) as independent dependency chains
+	struct VocoderFilterBank {
+		static constexpr auto MAX_BANDS = 64;
+
+		// Redesigns the band pass filters, state is kept so that the width can be changed while playing
+		void set_bands(float const freqs[], int num_bands, float Q) {
+			assert(num_bands <= MAX_BANDS);
+
+			num_groups = (num_bands + simd::WIDTH - 1) / simd::WIDTH;
+
+			for (int b = 0; b < num_groups * simd::WIDTH; b++) {
+				auto & group = groups[b / simd::WIDTH];
+				auto   lane  = b % simd::WIDTH;
+
+				// Lanes beyond the last band are padded with filters that output nothing
+				auto coefficients = b < num_bands
+					? BiQuadCoefficients::design(BiQuadFilterMode::BAND_PASS, freqs[b], Q)
+					: BiQuadCoefficients { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+				group.filters.set(lane, coefficients);
+			}
+		}
+
+		void reset_state() {
+			for (auto & group : groups) {
+				for (int lane = 0; lane < simd::WIDTH; lane++) {
+					for (auto & state : group.state) state[lane] = 0.0f;
+					group.gain[lane] = 0.0f;
+				}
+			}
+		}
+
+		// The envelope rises instantly and falls by decay_factor per sample
+		void process(Sample const modulator[BLOCK_SIZE], Sample const carrier[BLOCK_SIZE], Sample out[BLOCK_SIZE], float decay_factor) {
+			// Sums per lane, reduced to a single sample per channel once all groups are done
+			alignas(16) float sum_left [BLOCK_SIZE][simd::WIDTH] = { };
+			alignas(16) float sum_right[BLOCK_SIZE][simd::WIDTH] = { };
+
+			auto decay = simd::float4(decay_factor);
+			auto keep  = simd::float4(1.0f - decay_factor);
+
+			for (int g = 0; g < num_groups; g++) {
+				auto & group = groups[g];
+
+				auto filters = group.filters.load();
+
+				simd::float4 s1[NUM_FILTERS], s2[NUM_FILTERS];
+				for (int f = 0; f < NUM_FILTERS; f++) {
+					s1[f] = simd::float4::load(group.state[2 * f]);
+					s2[f] = simd::float4::load(group.state[2 * f + 1]);
+				}
+
+				auto gain = simd::float4::load(group.gain);
+
+				auto filter = [&](int f, simd::float4 const & x) { return filters.process(x, s1[f], s2[f]); };
+
+				for (int i = 0; i < BLOCK_SIZE; i++) {
+					auto mod_left  = filter(0, simd::float4(modulator[i].left));
+					auto mod_right = filter(1, simd::float4(modulator[i].right));
+					auto car_left  = filter(2, simd::float4(carrier  [i].left));
+					auto car_right = filter(3, simd::float4(carrier  [i].right));
+
+					auto mod_gain = simd::max(simd::abs(mod_left), simd::abs(mod_right));
+
+					// Gain increases instantaneously, but decreases slowly (low passed)
+					// The low passed gain lies between the old gain and mod_gain, so taking the max selects mod_gain exactly when it is larger
+					gain = simd::max(mod_gain, gain * keep + mod_gain * decay);
+
+					(simd::float4::load(sum_left [i]) + gain * car_left ).store(sum_left [i]);
+					(simd::float4::load(sum_right[i]) + gain * car_right).store(sum_right[i]);
+				}
+
+				for (int f = 0; f < NUM_FILTERS; f++) {
+					s1[f].store(group.state[2 * f]);
+					s2[f].store(group.state[2 * f + 1]);
+				}
+				gain.store(group.gain);
+			}
+
+			for (int i = 0; i < BLOCK_SIZE; i++) {
+				out[i] = Sample(
+					simd::hsum(simd::float4::load(sum_left [i])),
+					simd::hsum(simd::float4::load(sum_right[i]))
+				);
+			}
+		}
+
+	private:
+		static constexpr auto MAX_GROUPS  = MAX_BANDS / simd::WIDTH;
+		static constexpr auto NUM_FILTERS = 4; // Modulator left and right, carrier left and right
+
+		struct alignas(16) Group {
+			BiQuadLanes filters; // One band per lane, shared by the modulator and carrier of both channels
+
+			float state[2 * NUM_FILTERS][simd::WIDTH] = { }; // s1 and s2 per filter
+			float gain[simd::WIDTH] = { };                   // Envelope of the modulator per band
+		};
+
+		Group groups[MAX_GROUPS];
+		int   num_groups = 0;
+	};
+}
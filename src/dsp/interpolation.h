@@ -0,0 +1,125 @@
+#pragma once
+#include <vector>
+
+#include "util/util.h"
+#include "util/simd.h"
+
+namespace dsp {
+	enum struct Interpolation { LINEAR, CUBIC, SINC_8, SINC_32 };
+
+	// Number of frames every Interpolation mode reads around the position it interpolates at
+	// The frames passed to interpolate start TAPS / 2 - 1 frames before the integer part of the position
+	constexpr int get_taps(Interpolation interpolation) {
+		switch (interpolation) {
+			case Interpolation::LINEAR:  return 2;
+			case Interpolation::CUBIC:   return 4;
+			case Interpolation::SINC_8:  return 8;
+			case Interpolation::SINC_32: return 32;
+		}
+		return 0;
+	}
+
+	inline constexpr auto SINC_NUM_LEVELS = 9; // Level l has its cutoff at 2^(-l/4) times Nyquist, enough to play two octaves up without aliasing
+
+	// Level of the table returned by get_sinc_table with the highest cutoff that does not alias when frames are read step frames apart
+	inline int get_sinc_level(float step) {
+		if (step <= 1.0f) return 0;
+
+		return std::min(int(std::ceil(4.0f * std::log2(step))), SINC_NUM_LEVELS - 1);
+	}
+
+	// Lanczos windowed sinc kernel, tabulated at PHASES + 1 fractional positions for a number of cutoff frequencies (levels)
+	// Interpolation is then a dot product between TAPS frames and a (linearly interpolated) row of the table,
+	// no transcendental functions are evaluated while playing
+	template<int TAPS>
+	struct SincTable {
+		static_assert(TAPS % simd::WIDTH == 0);
+
+		static constexpr auto PHASES = 256;
+
+		// Builds one level per cutoff, cutoffs are relative to the Nyquist frequency of the input
+		explicit SincTable(std::vector<float> const & cutoffs) : data(cutoffs.size() * (PHASES + 1) * TAPS) {
+			auto half_width = float(TAPS / 2);
+
+			for (int level = 0; level < cutoffs.size(); level++) {
+				auto cutoff = cutoffs[level];
+
+				for (int phase = 0; phase <= PHASES; phase++) {
+					auto row = get_row(level, phase);
+					auto t   = float(phase) / float(PHASES);
+
+					auto sum = 0.0f;
+
+					for (int tap = 0; tap < TAPS; tap++) {
+						auto x = float(tap - (TAPS / 2 - 1)) - t; // Distance between the tap and the interpolated position
+
+						auto window = std::abs(x) < half_width ? util::sinc(PI * x / half_width) : 0.0f;
+
+						row[tap] = cutoff * util::sinc(PI * cutoff * x) * window;
+						sum += row[tap];
+					}
+
+					// Normalize so that DC passes at unity gain for every phase
+					for (int tap = 0; tap < TAPS; tap++) row[tap] /= sum;
+				}
+			}
+		}
+
+		// Interpolates at t in [0, 1) between frames[TAPS/2 - 1] and frames[TAPS/2]
+		Sample interpolate(Sample const * frames, float t, int level) const {
+			auto position = t * float(PHASES);
+			auto phase    = int(position);
+			auto weight   = simd::float4(position - float(phase));
+
+			auto row_0 = get_row(level, phase);
+			auto row_1 = row_0 + TAPS;
+
+			simd::float4 sum;
+
+			for (int tap = 0; tap < TAPS; tap += simd::WIDTH) {
+				auto coefficients = simd::lerp(simd::float4::loadu(row_0 + tap), simd::float4::loadu(row_1 + tap), weight);
+
+				// Frames are stored as interleaved left/right pairs, so every coefficient is used twice
+				auto frames_01 = simd::float4::loadu(&frames[tap]    .left);
+				auto frames_23 = simd::float4::loadu(&frames[tap + 2].left);
+
+				sum += frames_01 * simd::interleave_lo(coefficients, coefficients);
+				sum += frames_23 * simd::interleave_hi(coefficients, coefficients);
+			}
+
+			return Sample(sum[0] + sum[2], sum[1] + sum[3]);
+		}
+
+	private:
+		std::vector<float> data; // One block of (PHASES + 1) rows of TAPS coefficients per level
+
+		float       * get_row(int level, int phase)       { return &data[(level * (PHASES + 1) + phase) * TAPS]; }
+		float const * get_row(int level, int phase) const { return &data[(level * (PHASES + 1) + phase) * TAPS]; }
+	};
+
+	// Table with SINC_NUM_LEVELS levels for playback at a variable rate, see get_sinc_level
+	// The tables are built on first use
+	template<int TAPS>
+	SincTable<TAPS> const & get_sinc_table() {
+		static SincTable<TAPS> const table = [] {
+			std::vector<float> cutoffs(SINC_NUM_LEVELS);
+
+			for (int level = 0; level < SINC_NUM_LEVELS; level++) {
+				cutoffs[level] = std::exp2(-0.25f * float(level));
+			}
+
+			return SincTable<TAPS>(cutoffs);
+		}();
+
+		return table;
+	}
+
+	// Catmull-Rom spline through frames[0..3], interpolates between frames[1] and frames[2]
+	inline Sample interpolate_cubic(Sample const * frames, float t) {
+		auto c1 = 0.5f * (frames[2] - frames[0]);
+		auto c2 = frames[0] - 2.5f * frames[1] + 2.0f * frames[2] - 0.5f * frames[3];
+		auto c3 = 0.5f * (frames[3] - frames[0]) + 1.5f * (frames[1] - frames[2]);
+
+		return ((c3 * t + c2) * t + c1) * t + frames[1];
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+#include "interpolation.h"
+
+namespace dsp {
+	// Converts frames from one sample rate to another, meant to run once when a sample is loaded rather than while playing
+	// Uses a 64 tap windowed sinc with its cutoff just below the lower of the two Nyquist frequencies
+	inline std::vector<Sample> resample(std::vector<Sample> const & samples, int rate_from, int rate_to) {
+		static constexpr auto TAPS   = 64;
+		static constexpr auto BEFORE = TAPS / 2 - 1;
+		static constexpr auto AFTER  = TAPS / 2;
+
+		if (rate_from == rate_to || samples.empty()) return samples;
+
+		auto ratio  = double(rate_from) / double(rate_to); // Input frames per output frame
+		auto cutoff = 0.95f * std::min(1.0f, float(rate_to) / float(rate_from));
+
+		SincTable<TAPS> table({ cutoff });
+
+		// Pad with silence so the taps never read out of bounds
+		std::vector<Sample> padded(BEFORE + samples.size() + AFTER + 1);
+		std::copy(samples.begin(), samples.end(), padded.begin() + BEFORE);
+
+		std::vector<Sample> result(size_t(std::ceil(double(samples.size()) / ratio)));
+
+		for (size_t i = 0; i < result.size(); i++) {
+			auto position = double(i) * ratio;
+			auto index    = size_t(position);
+
+			result[i] = table.interpolate(&padded[index], float(position - double(index)), 0);
+		}
+
+		return result;
+	}
+}
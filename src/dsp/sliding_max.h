@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+#include "util/util.h"
+
+namespace dsp {
+	// Maximum over the most recent window + 1 values of a stream, in amortized constant time per value
+	// Values are kept in a monotonic deque: every value is dropped as soon as a newer value at least as large arrives,
+	// so the deque is decreasing from front to back and its front is the maximum of the window
+	//
+	// The deque lives in a ring buffer sized for the largest window, so changing the window while playing never allocates
+	struct SlidingMax {
+		SlidingMax() = default;
+
+		explicit SlidingMax(int max_window) { resize(max_window); }
+
+		void resize(int max_window) {
+			// The window holds window + 1 values, so right after a push and before the front drops out the deque can hold window + 2
+			auto size = util::next_power_of_two(max_window + 2);
+
+			entries.assign(size, { });
+			mask = size - 1;
+
+			this->max_window = max_window;
+
+			clear();
+		}
+
+		void clear() {
+			head = 0;
+			tail = 0;
+		}
+
+		// Adds a value and returns the maximum of it and the window values before it
+		float next(float value, int window) {
+			assert(window >= 0 && window <= max_window);
+
+			while (tail != head && entries[(tail - 1) & mask].value <= value) tail--;
+
+			entries[tail & mask] = { value, position };
+			tail++;
+
+			// Values older than the window drop out at the front, unsigned arithmetic keeps the age correct when position wraps
+			while (position - entries[head & mask].position > unsigned(window)) head++;
+
+			position++;
+
+			return entries[head & mask].value;
+		}
+
+	private:
+		struct Entry {
+			float    value;
+			unsigned position;
+		};
+
+		std::vector<Entry> entries;
+
+		int mask       = 0;
+		int max_window = 0;
+
+		unsigned head = 0; // Front (oldest and largest) and one past the back of the deque, wrapped using mask
+		unsigned tail = 0;
+
+		unsigned position = 0; // Number of values seen
+	};
+}
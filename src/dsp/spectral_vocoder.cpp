@@ -0,0 +1,134 @@
+#include "spectral_vocoder.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "fft.h"
+
+#include "util/util.h"
+
+dsp::SpectralVocoder::SpectralVocoder() {
+	for (int i = 0; i < FFT_SIZE; i++) {
+		window[i] = std::sin(PI * float(i) / float(FFT_SIZE)); // Periodic, so that the Hann windows of overlapping frames sum to a constant
+	}
+
+	std::fill(bin_band, bin_band + NUM_BINS, -1.0f);
+}
+
+void dsp::SpectralVocoder::set_bands(float const freqs[], int num_bands) {
+	assert(num_bands >= 1 && num_bands <= MAX_BANDS);
+
+	this->num_bands = num_bands;
+
+	// Spacing (as a ratio of frequencies) used below the first and above the last band
+	auto ratio_first = num_bands > 1 ? freqs[1]             / freqs[0]             : 2.0f;
+	auto ratio_last  = num_bands > 1 ? freqs[num_bands - 1] / freqs[num_bands - 2] : 2.0f;
+
+	auto band = 0;
+
+	for (int k = 0; k < NUM_BINS; k++) {
+		auto freq = std::max(float(k), 0.5f) * float(SAMPLE_RATE) / float(FFT_SIZE);
+
+		while (band < num_bands - 1 && freqs[band + 1] <= freq) band++;
+
+		if (freq < freqs[0]) {
+			bin_band[k] = std::log(freq / freqs[0]) / std::log(ratio_first);
+		} else if (band == num_bands - 1) {
+			bin_band[k] = float(band) + std::log(freq / freqs[band]) / std::log(ratio_last);
+		} else {
+			bin_band[k] = float(band) + std::log(freq / freqs[band]) / std::log(freqs[band + 1] / freqs[band]);
+		}
+	}
+}
+
+void dsp::SpectralVocoder::reset_state() {
+	std::fill(envelope, envelope + MAX_BANDS, 0.0f);
+
+	std::fill(history_modulator, history_modulator + FFT_SIZE, Sample(0.0f));
+	std::fill(history_carrier,   history_carrier   + FFT_SIZE, Sample(0.0f));
+	std::fill(overlap,           overlap           + FFT_SIZE, Sample(0.0f));
+}
+
+void dsp::SpectralVocoder::process(Sample const modulator[BLOCK_SIZE], Sample const carrier[BLOCK_SIZE], Sample out[BLOCK_SIZE], float decay_factor) {
+	for (int offset = 0; offset < BLOCK_SIZE; offset += HOP_SIZE) {
+		std::copy(history_modulator + HOP_SIZE, history_modulator + FFT_SIZE, history_modulator);
+		std::copy(history_carrier   + HOP_SIZE, history_carrier   + FFT_SIZE, history_carrier);
+
+		std::copy(modulator + offset, modulator + offset + HOP_SIZE, history_modulator + FFT_SIZE - HOP_SIZE);
+		std::copy(carrier   + offset, carrier   + offset + HOP_SIZE, history_carrier   + FFT_SIZE - HOP_SIZE);
+
+		process_frame(decay_factor);
+
+		std::copy(overlap, overlap + HOP_SIZE, out + offset);
+
+		std::copy(overlap + HOP_SIZE, overlap + FFT_SIZE, overlap);
+		std::fill(overlap + FFT_SIZE - HOP_SIZE, overlap + FFT_SIZE, Sample(0.0f));
+	}
+}
+
+void dsp::SpectralVocoder::process_frame(float decay_factor) {
+	for (int i = 0; i < FFT_SIZE; i++) {
+		spectrum_modulator[i] = window[i] * history_modulator[i];
+		spectrum_carrier  [i] = window[i] * history_carrier  [i];
+	}
+
+	fft<FFT_SIZE>(spectrum_modulator);
+	fft<FFT_SIZE>(spectrum_carrier);
+
+	// Every bin adds its energy to the two bands it lies between, weighted by how close it is to their centers
+	auto weights = [this](int k, auto && func) {
+		auto position = bin_band[k];
+		auto band     = int(std::floor(position));
+		auto t        = position - float(band);
+
+		if (band     >= 0 && band     < num_bands) func(band,     1.0f - t);
+		if (band + 1 >= 0 && band + 1 < num_bands) func(band + 1, t);
+	};
+
+	float energy[MAX_BANDS] = { };
+
+	for (int k = 1; k < FFT_SIZE / 2; k++) {
+		auto z        = spectrum_modulator[k];
+		auto z_mirror = spectrum_modulator[FFT_SIZE - k];
+
+		// Mean of |L_k|^2 and |R_k|^2 of the two channels packed into z
+		auto e = 0.25f * (z.left * z.left + z.right * z.right + z_mirror.left * z_mirror.left + z_mirror.right * z_mirror.right);
+
+		weights(k, [&](int band, float weight) { energy[band] += weight * e; });
+	}
+
+	// A sine wave of amplitude A has an energy of (A N)^2 / 8 in the positive bins of a square root Hann windowed transform
+	auto to_amplitude = std::sqrt(8.0f) / float(FFT_SIZE);
+
+	// The decay per sample applied for a whole hop
+	auto decay_hop = 1.0f - std::pow(1.0f - decay_factor, float(HOP_SIZE));
+
+	for (int b = 0; b < num_bands; b++) {
+		auto amplitude = to_amplitude * std::sqrt(energy[b]);
+
+		if (envelope[b] < amplitude) {
+			envelope[b] = amplitude; // Gain increases instantaneously
+		} else {
+			envelope[b] = util::lerp(envelope[b], amplitude, decay_hop); // Gain decreases slowly (low passed)
+		}
+	}
+
+	// The gain of a bin is the same for the positive and negative frequency, so that both channels get the same gain
+	for (int k = 0; k <= FFT_SIZE / 2; k++) {
+		auto gain = 0.0f;
+		weights(k, [&](int band, float weight) { gain += weight * envelope[band]; });
+
+		spectrum_carrier[k] = gain * spectrum_carrier[k];
+
+		if (k > 0 && k < FFT_SIZE / 2) {
+			spectrum_carrier[FFT_SIZE - k] = gain * spectrum_carrier[FFT_SIZE - k];
+		}
+	}
+
+	ifft<FFT_SIZE>(spectrum_carrier);
+
+	// Square root Hann windows on both sides make a Hann window, four of which overlap to a sum of 2
+	for (int i = 0; i < FFT_SIZE; i++) {
+		overlap[i] += (0.5f * window[i]) * spectrum_carrier[i];
+	}
+}
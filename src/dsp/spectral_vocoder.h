@@ -0,0 +1,53 @@
+#pragma once
+#include "synth/sample.h"
+
+namespace dsp {
+	// Vocoder that works on short time Fourier transforms instead of a filter bank, its cost does not depend on the number of bands
+	//
+	// Every HOP_SIZE samples a window of FFT_SIZE samples of both the modulator and the carrier is transformed
+	// The energy of the modulator is gathered per band, every bin contributes to the two bands it lies between (in log frequency),
+	// the carrier bins are then scaled by the band envelopes interpolated the same way and overlap-added back into the output
+	// The left and right channel are packed into the real and imaginary part of a single complex FFT,
+	// which is possible since both the band energies and the gains per bin are symmetric in frequency
+	//
+	// The output lags the input by LATENCY samples
+	struct SpectralVocoder {
+		static constexpr auto FFT_SIZE = 1024;
+		static constexpr auto HOP_SIZE = FFT_SIZE / 4;
+		static constexpr auto LATENCY  = FFT_SIZE - HOP_SIZE;
+
+		static constexpr auto MAX_BANDS = 64;
+		static constexpr auto NUM_BINS  = FFT_SIZE / 2 + 1;
+
+		static_assert(BLOCK_SIZE % HOP_SIZE == 0);
+
+		SpectralVocoder();
+
+		// Bands are centered on the given frequencies, which have to be increasing
+		void set_bands(float const freqs[], int num_bands);
+
+		void reset_state();
+
+		// The envelope rises instantly and falls by decay_factor per sample
+		void process(Sample const modulator[BLOCK_SIZE], Sample const carrier[BLOCK_SIZE], Sample out[BLOCK_SIZE], float decay_factor);
+
+	private:
+		float window[FFT_SIZE]; // Square root of a Hann window, applied both before and after the transform
+
+		// Position of every bin in band units, bin k lies between band floor(bin_band[k]) and the one above it
+		float bin_band[NUM_BINS];
+		int   num_bands = 0;
+
+		float envelope[MAX_BANDS] = { };
+
+		Sample history_modulator[FFT_SIZE] = { };
+		Sample history_carrier  [FFT_SIZE] = { };
+
+		Sample overlap[FFT_SIZE] = { }; // Overlap-added output, the first HOP_SIZE samples are complete
+
+		Sample spectrum_modulator[FFT_SIZE];
+		Sample spectrum_carrier  [FFT_SIZE];
+
+		void process_frame(float decay_factor);
+	};
+}
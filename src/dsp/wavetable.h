@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+
+#include "fft.h"
+
+#include "util/simd.h"
+
+namespace dsp {
+	enum struct WaveTableInterpolation { LINEAR, CUBIC };
+
+	// Single cycle waveform stored as a mip map of band limited tables, one per octave
+	// Level l only contains harmonics up to (SIZE / 2) >> l, so it can be played up to a phase delta of 2^l / SIZE without aliasing
+	struct WaveTable {
+		static constexpr auto SIZE       = 2048;
+		static constexpr auto NUM_LEVELS = util::log2(SIZE);
+		static constexpr auto STRIDE     = 1 + SIZE + 3; // One guard sample before and three after every level, so interpolation never has to wrap
+
+		WaveTable() = default;
+
+		// Builds the mip map from a single cycle of arbitrary length, which is resampled to SIZE
+		WaveTable(float const * cycle, int length) : data(NUM_LEVELS * STRIDE) {
+			std::vector<float> resampled(SIZE);
+
+			for (int i = 0; i < SIZE; i++) {
+				auto position = float(i) * float(length) / float(SIZE);
+				auto index    = int(position);
+
+				resampled[i] = util::lerp(cycle[index], cycle[(index + 1) % length], position - float(index));
+			}
+
+			std::vector<Sample> spectrum(SIZE / 2 + 1);
+			rfft<SIZE>(resampled.data(), spectrum.data());
+
+			std::vector<Sample> level_spectrum(SIZE / 2 + 1);
+
+			for (int level = 0; level < NUM_LEVELS; level++) {
+				auto max_harmonic = std::min((SIZE / 2) >> level, SIZE / 2 - 1);
+
+				// Keep harmonics 1 to max_harmonic, remove DC and everything above
+				for (int k = 0; k <= SIZE / 2; k++) {
+					level_spectrum[k] = (k >= 1 && k <= max_harmonic) ? spectrum[k] : Sample(0.0f, 0.0f);
+				}
+
+				auto table = &data[level * STRIDE + 1];
+
+				irfft<SIZE>(level_spectrum.data(), table);
+
+				table[-1]       = table[SIZE - 1];
+				table[SIZE]     = table[0];
+				table[SIZE + 1] = table[1];
+				table[SIZE + 2] = table[2];
+			}
+		}
+
+		// Builds the mip map from a function that maps phase (in [0, 1)) to amplitude
+		template<typename Function>
+		static WaveTable from_function(Function func) {
+			std::vector<float> cycle(SIZE);
+
+			for (int i = 0; i < SIZE; i++) {
+				cycle[i] = func(float(i) / float(SIZE));
+			}
+
+			return WaveTable(cycle.data(), SIZE);
+		}
+
+		// Lowest (most detailed) level that does not alias when the table is played at the given phase delta (in cycles per sample)
+		static int get_level(float phase_delta) {
+			auto level = int(std::ceil(std::log2(std::max(phase_delta * float(SIZE), 1.0f))));
+
+			return std::min(level, NUM_LEVELS - 1);
+		}
+
+		// Samples simd::WIDTH phases (in cycles) at once, every lane reads from its own mip map level
+		template<WaveTableInterpolation INTERPOLATION = WaveTableInterpolation::LINEAR>
+		simd::float4 sample(simd::float4 phase, int const levels[simd::WIDTH]) const {
+			auto position = simd::frac(phase) * float(SIZE);
+			auto index    = simd::floor(position);
+			auto t        = position - index;
+
+			alignas(16) float indices[simd::WIDTH];
+			index.store(indices);
+
+			alignas(16) float p0[simd::WIDTH];
+			alignas(16) float p1[simd::WIDTH];
+			alignas(16) float p2[simd::WIDTH];
+			alignas(16) float p3[simd::WIDTH];
+
+			// Gather
+			for (int lane = 0; lane < simd::WIDTH; lane++) {
+				auto ptr = &data[levels[lane] * STRIDE + 1 + int(indices[lane])];
+
+				p0[lane] = ptr[-1];
+				p1[lane] = ptr[ 0];
+				p2[lane] = ptr[ 1];
+				p3[lane] = ptr[ 2];
+			}
+
+			auto y0 = simd::float4::load(p0);
+			auto y1 = simd::float4::load(p1);
+			auto y2 = simd::float4::load(p2);
+			auto y3 = simd::float4::load(p3);
+
+			if constexpr (INTERPOLATION == WaveTableInterpolation::LINEAR) {
+				return simd::lerp(y1, y2, t);
+			} else {
+				// Catmull-Rom spline
+				auto c1 = 0.5f * (y2 - y0);
+				auto c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+				auto c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+
+				return ((c3 * t + c2) * t + c1) * t + y1;
+			}
+		}
+
+		bool is_empty() const { return data.empty(); }
+
+	private:
+		std::vector<float> data; // NUM_LEVELS tables of STRIDE samples each
+	};
+
+	// Band limited versions of the basic Oscillator waveforms (sine, triangle, saw, square, 25% and 12.5% pulse)
+	// The tables are built on first use
+	inline WaveTable const & get_basic_wavetable(int waveform) {
+		auto pulse = [](float pulse_width) {
+			return [pulse_width](float phase) { return phase < pulse_width ? 1.0f : -1.0f; };
+		};
+
+		static WaveTable const tables[] = {
+			WaveTable::from_function([](float phase) { return std::sin(TWO_PI * phase); }),
+			WaveTable::from_function([](float phase) { return 4.0f * std::abs(phase + 0.25f - std::floor(phase + 0.75f)) - 1.0f; }),
+			WaveTable::from_function([](float phase) { return 2.0f * (phase - std::floor(phase + 0.5f)); }),
+			WaveTable::from_function(pulse(0.5f)),
+			WaveTable::from_function(pulse(0.25f)),
+			WaveTable::from_function(pulse(0.125f))
+		};
+
+		assert(0 <= waveform && waveform < std::size(tables));
+		return tables[waveform];
+	}
+}
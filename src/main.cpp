@@ -18,7 +18,9 @@
 #include "util/ring_buffer.h"
 
 #include "synth/midi.h"
+#include "synth/streaming.h"
 #include "synth/synth.h"
+#include "synth/benchmark.h"
 
 extern "C" { _declspec(dllexport) unsigned NvOptimusEnablement = true; }
 
@@ -44,6 +46,11 @@ static void sdl_audio_callback(void * user_data, Uint8 * stream, int len) {
 }
 
 int main(int argc, char * argv[]) {
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		benchmark::run();
+		return 0;
+	}
+
 	SDL_Init(SDL_INIT_EVERYTHING);
 
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
@@ -99,6 +106,7 @@ int main(int argc, char * argv[]) {
 	SDL_PauseAudioDevice(device, false);
 
 	midi::open();
+	streaming::open();
 
 	Synth synth;
 
@@ -187,6 +195,7 @@ int main(int argc, char * argv[]) {
 	terminated = true;
 
 	midi::close();
+	streaming::close();
 	
 	ImGui_ImplSDL2_Shutdown();
 	ImGui_ImplOpenGL3_Shutdown();
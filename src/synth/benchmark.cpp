@@ -0,0 +1,198 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <random>
+
+#include "synth.h"
+
+#include "dsp/fft.h"
+#include "dsp/biquad_cascade.h"
+
+static constexpr auto NUM_BLOCKS = 1000;
+
+// Measures the time it takes to render a block with the given number of Voices held down
+template<IsComponent T>
+static void benchmark_polyphony(char const * name, int num_voices) {
+	Synth synth;
+	synth.open_file("projects/empty.json");
+
+	auto keyboard  = synth.add_component<KeyboardComponent>();
+	auto component = synth.add_component<T>();
+	auto speaker   = synth.add_component<SpeakerComponent>();
+
+	component->polyphony = T::MAX_VOICES;
+
+	synth.connect(keyboard ->outputs[0], component->inputs[0]);
+	synth.connect(component->outputs[0], speaker  ->inputs[0]);
+
+	for (int v = 0; v < num_voices; v++) {
+		synth.note_press(util::note<util::NoteName::C, 1>() + v % 96, 0.5f);
+	}
+
+	Sample buf[BLOCK_SIZE];
+
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	for (int b = 0; b < NUM_BLOCKS; b++) synth.update(buf);
+
+	auto stop_time = std::chrono::high_resolution_clock::now();
+
+	auto us_per_block = std::chrono::duration<double, std::micro>(stop_time - start_time).count() / double(NUM_BLOCKS);
+	auto us_budget    = 1000000.0 * double(BLOCK_SIZE) / double(SAMPLE_RATE); // Time available to render a block in real-time
+
+	printf("%-12s %3i voices: %8.1f us per block (%5.1f%% of real-time budget)\n", name, num_voices, us_per_block, 100.0 * us_per_block / us_budget);
+}
+
+// The scalar radix-2 FFT that dsp::FFTPlan replaced, kept as a baseline
+// Based on: https://gist.github.com/agrafix/aa49c17cd32c8ba63b6a7cb8dce8b0bd
+template<int N>
+static void fft_radix2(Sample fourier[]) {
+	// Reverse bits
+	auto i2 = N / 2;
+	auto j = 0;
+	for (int i = 0; i < N - 1; i++) {
+		if (i < j) {
+			std::swap(fourier[i], fourier[j]);
+		}
+
+		auto k = i2;
+		while (k <= j) {
+			j -= k;
+			k /= 2;
+		}
+		j += k;
+	}
+
+	// Fourier Transform
+	auto c_re = -1.0;
+	auto c_im =  0.0;
+	auto l2   = 1;
+
+	for (int l = 0; l < util::log2(N); l++) {
+		auto l1 = l2;
+		l2 <<= 1;
+		auto u1 = 1.0;
+		auto u2 = 0.0;
+
+		for (j = 0; j < l1; j++) {
+			for (int i = j; i < N; i += l2) {
+				auto i1 = i + l1;
+
+				auto t1 = float(u1) * fourier[i1].left  - float(u2) * fourier[i1].right;
+				auto t2 = float(u1) * fourier[i1].right + float(u2) * fourier[i1].left;
+
+				fourier[i1].left  = fourier[i].left  - t1;
+				fourier[i1].right = fourier[i].right - t2;
+				fourier[i].left  += t1;
+				fourier[i].right += t2;
+			}
+
+			auto z = u1 * c_re - u2 * c_im;
+			u2     = u1 * c_im + u2 * c_re;
+			u1     = z;
+		}
+
+		c_im = -std::sqrt(0.5 - 0.5 * c_re);
+		c_re =  std::sqrt(0.5 + 0.5 * c_re);
+	}
+}
+
+// Measures the average time of a function over many runs, in microseconds
+template<typename Function>
+static double time_us(int num_runs, Function func) {
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	for (int r = 0; r < num_runs; r++) func();
+
+	auto stop_time = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::micro>(stop_time - start_time).count() / double(num_runs);
+}
+
+// Compares the radix-2 FFT against the complex and real transforms of dsp::FFTPlan, all on the same real input
+template<int N>
+static void benchmark_fft() {
+	static constexpr auto NUM_RUNS = 2000;
+
+	std::mt19937 rng(N);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+	std::vector<float> input(N);
+	for (auto & value : input) value = dist(rng);
+
+	std::vector<Sample> complex(N);
+	std::vector<Sample> bins(N / 2 + 1);
+
+	auto reset = [&]() {
+		for (int i = 0; i < N; i++) complex[i] = Sample(input[i], 0.0f);
+	};
+
+	auto us_radix2 = time_us(NUM_RUNS, [&]() { reset(); fft_radix2<N>(complex.data()); });
+	auto us_plan   = time_us(NUM_RUNS, [&]() { reset(); dsp::fft  <N>(complex.data()); });
+	auto us_real   = time_us(NUM_RUNS, [&]() { dsp::rfft<N>(input.data(), bins.data()); });
+
+	// Largest difference between the bins of the real transform and the radix-2 reference, relative to the largest bin
+	reset();
+	fft_radix2<N>(complex.data());
+
+	auto max_error     = 0.0f;
+	auto max_magnitude = 0.0f;
+	for (int k = 0; k <= N / 2; k++) {
+		max_error     = std::max(max_error,     std::hypot(bins[k].left - complex[k].left, bins[k].right - complex[k].right));
+		max_magnitude = std::max(max_magnitude, std::hypot(complex[k].left, complex[k].right));
+	}
+
+	printf("FFT %5i: radix-2 %7.2f us, plan %7.2f us (%4.1fx), real %7.2f us (%4.1fx), relative error %.1e\n",
+		N, us_radix2, us_plan, us_radix2 / us_plan, us_real, us_radix2 / us_real, max_error / max_magnitude);
+}
+
+// Compares a cascade of peak filters against the same number of BiQuadFilters run one after the other,
+// which is how the Equalizer used to process its bands (redesigning every band every block)
+static void benchmark_biquad_cascade(int num_sections) {
+	static constexpr auto NUM_RUNS = 2000;
+
+	std::mt19937 rng(num_sections);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+	Sample input[BLOCK_SIZE];
+	for (auto & sample : input) sample = Sample(dist(rng), dist(rng));
+
+	auto freq = [num_sections](int s) { return util::log_interpolate(40.0f, 16000.0f, (s + 0.5f) / float(num_sections)); };
+
+	std::vector<dsp::BiQuadFilter<Sample>> filters(num_sections);
+	Sample output_serial[BLOCK_SIZE];
+
+	auto us_serial = time_us(NUM_RUNS, [&]() {
+		for (int s = 0; s < num_sections; s++) filters[s].set(dsp::BiQuadFilterMode::PEAK, freq(s), 1.0f, 3.0f);
+
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			auto sample = input[i];
+			for (auto & filter : filters) sample = filter.process(sample);
+
+			output_serial[i] = sample;
+		}
+	});
+
+	dsp::BiQuadCascade cascade;
+	for (int s = 0; s < num_sections; s++) {
+		cascade.add_section();
+		cascade.set_section(s, dsp::BiQuadCoefficients::design(dsp::BiQuadFilterMode::PEAK, freq(s), 1.0f, 3.0f));
+	}
+	Sample output_cascade[BLOCK_SIZE];
+
+	auto us_cascade = time_us(NUM_RUNS, [&]() { cascade.process(input, output_cascade); });
+
+	printf("BiQuad %2i sections: serial %6.2f us, cascade %6.2f us (%4.1fx)\n", num_sections, us_serial, us_cascade, us_serial / us_cascade);
+}
+
+void benchmark::run() {
+	benchmark_fft<512>();
+	benchmark_fft<1024>();
+	benchmark_fft<4096>();
+	benchmark_fft<8192>();
+
+	for (auto num_sections : { 4, 8, 16, 32 }) benchmark_biquad_cascade(num_sections);
+
+	for (auto num_voices : { 1, 16, 64, 128 }) benchmark_polyphony<OscillatorComponent>("Oscillator", num_voices);
+	for (auto num_voices : { 1, 16, 64, 128 }) benchmark_polyphony<FM6Component>       ("FM 6-Op",    num_voices);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace benchmark {
+	// Runs all benchmarks and prints the results, invoked with the --benchmark command line argument
+	void run();
+}
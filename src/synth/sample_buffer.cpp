@@ -0,0 +1,193 @@
+#include "sample_buffer.h"
+
+#include <cstring>
+#include <cstdint>
+
+#include "util/simd.h"
+
+static constexpr auto S16_SCALE = 1.0f / float(INT16_MAX);
+static constexpr auto S24_SCALE = 1.0f / 8388607.0f;
+
+SampleBuffer SampleBuffer::from_wav(util::WavInfo const & info, unsigned char const * file) {
+	SampleBuffer buffer;
+	buffer.channels = info.channels;
+	buffer.length   = info.num_frames;
+
+	auto src = file + info.data_offset;
+	auto num_values = size_t(info.num_frames) * info.channels;
+
+	switch (info.format) {
+		case util::WavInfo::Format::PCM_U8: {
+			buffer.format = Format::S16;
+			buffer.data.resize(num_values * 2);
+
+			for (size_t i = 0; i < num_values; i++) {
+				auto value = int16_t((int(src[i]) - 128) * 256);
+				memcpy(&buffer.data[2 * i], &value, 2);
+			}
+
+			break;
+		}
+
+		case util::WavInfo::Format::PCM_S16: buffer.format = Format::S16; buffer.data.assign(src, src + num_values * 2); break;
+		case util::WavInfo::Format::PCM_S24: buffer.format = Format::S24; buffer.data.assign(src, src + num_values * 3); break;
+
+		case util::WavInfo::Format::PCM_S32:
+		case util::WavInfo::Format::FLOAT_32: {
+			buffer.format = Format::F32;
+			buffer.data.resize(num_values * 4);
+
+			std::vector<Sample> frames(info.num_frames);
+			util::decode_wav_frames(info, file, 0, info.num_frames, frames.data());
+
+			auto dst = reinterpret_cast<float *>(buffer.data.data());
+
+			if (info.channels == 1) {
+				for (int i = 0; i < info.num_frames; i++) dst[i] = frames[i].left;
+			} else {
+				memcpy(dst, frames.data(), frames.size() * sizeof(Sample));
+			}
+
+			break;
+		}
+	}
+
+	return buffer;
+}
+
+SampleBuffer SampleBuffer::from_samples(std::vector<Sample> const & samples) {
+	SampleBuffer buffer;
+	buffer.format   = Format::F32;
+	buffer.channels = 2;
+	buffer.length   = int(samples.size());
+
+	buffer.data.resize(samples.size() * sizeof(Sample));
+	memcpy(buffer.data.data(), samples.data(), buffer.data.size());
+
+	return buffer;
+}
+
+// Converts count values to float and writes them as stereo frames, a mono value is written to both channels
+template<int CHANNELS, typename Convert>
+static void convert_scalar(unsigned char const * src, int value_size, int count, float * dst, Convert convert) {
+	for (int i = 0; i < count; i++) {
+		auto value = convert(src + i * value_size);
+
+		if constexpr (CHANNELS == 1) {
+			dst[2*i]     = value;
+			dst[2*i + 1] = value;
+		} else {
+			dst[i] = value;
+		}
+	}
+}
+
+template<int CHANNELS>
+static void decode_s16(int16_t const * src, int count, float * dst) {
+	auto num_values = count * CHANNELS;
+	auto i = 0;
+
+#if SIMD_SSE
+	auto scale = _mm_set1_ps(S16_SCALE);
+
+	for (; i + 8 <= num_values; i += 8) {
+		auto packed = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+
+		// Sign extend to 32 bit by unpacking into the high half and shifting back down
+		auto lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16)), scale);
+		auto hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16)), scale);
+
+		if constexpr (CHANNELS == 1) {
+			_mm_storeu_ps(dst + 2*i,      _mm_unpacklo_ps(lo, lo));
+			_mm_storeu_ps(dst + 2*i + 4,  _mm_unpackhi_ps(lo, lo));
+			_mm_storeu_ps(dst + 2*i + 8,  _mm_unpacklo_ps(hi, hi));
+			_mm_storeu_ps(dst + 2*i + 12, _mm_unpackhi_ps(hi, hi));
+		} else {
+			_mm_storeu_ps(dst + i,     lo);
+			_mm_storeu_ps(dst + i + 4, hi);
+		}
+	}
+#endif
+
+	convert_scalar<CHANNELS>(reinterpret_cast<unsigned char const *>(src + i), 2, num_values - i, dst + (CHANNELS == 1 ? 2*i : i), [](unsigned char const * ptr) {
+		int16_t value; memcpy(&value, ptr, 2);
+		return float(value) * S16_SCALE;
+	});
+}
+
+template<int CHANNELS>
+static void decode_s24(unsigned char const * src, int count, float * dst) {
+	auto num_values = count * CHANNELS;
+	auto i = 0;
+
+#if SIMD_SSE
+	auto scale = _mm_set1_ps(S24_SCALE);
+
+	// Without SSSE3 there is no byte shuffle, so the 24 bit values are assembled with scalar loads and only the conversion is vectorized
+	for (; i + 4 <= num_values; i += 4) {
+		auto p = src + 3*i;
+
+		auto packed = _mm_setr_epi32(
+			int(uint32_t(p[0]) << 8 | uint32_t(p[1])  << 16 | uint32_t(p[2])  << 24),
+			int(uint32_t(p[3]) << 8 | uint32_t(p[4])  << 16 | uint32_t(p[5])  << 24),
+			int(uint32_t(p[6]) << 8 | uint32_t(p[7])  << 16 | uint32_t(p[8])  << 24),
+			int(uint32_t(p[9]) << 8 | uint32_t(p[10]) << 16 | uint32_t(p[11]) << 24)
+		);
+
+		auto values = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(packed, 8)), scale);
+
+		if constexpr (CHANNELS == 1) {
+			_mm_storeu_ps(dst + 2*i,     _mm_unpacklo_ps(values, values));
+			_mm_storeu_ps(dst + 2*i + 4, _mm_unpackhi_ps(values, values));
+		} else {
+			_mm_storeu_ps(dst + i, values);
+		}
+	}
+#endif
+
+	convert_scalar<CHANNELS>(src + 3*i, 3, num_values - i, dst + (CHANNELS == 1 ? 2*i : i), [](unsigned char const * ptr) {
+		auto value = int32_t(uint32_t(ptr[0]) << 8 | uint32_t(ptr[1]) << 16 | uint32_t(ptr[2]) << 24) >> 8; // Sign extend
+		return float(value) * S24_SCALE;
+	});
+}
+
+void SampleBuffer::decode(int first, int count, Sample * out) const {
+	auto src = data.data() + size_t(first) * bytes_per_frame();
+	auto dst = reinterpret_cast<float *>(out);
+
+	switch (format) {
+		case Format::S16: {
+			auto values = reinterpret_cast<int16_t const *>(src);
+
+			if (channels == 1) {
+				decode_s16<1>(values, count, dst);
+			} else {
+				decode_s16<2>(values, count, dst);
+			}
+
+			break;
+		}
+
+		case Format::S24: {
+			if (channels == 1) {
+				decode_s24<1>(src, count, dst);
+			} else {
+				decode_s24<2>(src, count, dst);
+			}
+
+			break;
+		}
+
+		case Format::F32: {
+			if (channels == 1) {
+				auto values = reinterpret_cast<float const *>(src);
+
+				for (int i = 0; i < count; i++) out[i] = values[i];
+			} else {
+				memcpy(out, src, size_t(count) * sizeof(Sample));
+			}
+
+			break;
+		}
+	}
+}
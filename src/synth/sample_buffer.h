@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+
+#include "sample.h"
+
+#include "util/wav.h"
+
+// Frames kept in the bit depth and channel count of the file they were loaded from, rather than as stereo floats
+// A 16 bit mono sample takes a quarter of the memory, frames are decoded to Samples when they are played
+struct SampleBuffer {
+	enum struct Format { S16, S24, F32 };
+
+	Format format   = Format::F32;
+	int    channels = 2;
+	int    length   = 0; // In frames
+
+	std::vector<unsigned char> data;
+
+	// 8 bit files are widened to 16 bit, 32 bit integer files are stored as float
+	static SampleBuffer from_wav(util::WavInfo const & info, unsigned char const * file);
+
+	static SampleBuffer from_samples(std::vector<Sample> const & samples);
+
+	int bytes_per_frame() const {
+		switch (format) {
+			case Format::S16: return channels * 2;
+			case Format::S24: return channels * 3;
+			case Format::F32: return channels * 4;
+		}
+		return 0;
+	}
+
+	// Decodes frames [first, first + count) to stereo, mono is copied to both channels
+	void decode(int first, int count, Sample * out) const;
+};
@@ -0,0 +1,162 @@
+#include "sample_cache.h"
+
+#include <cstdio>
+#include <mutex>
+#include <filesystem>
+#include <unordered_map>
+
+#include "util/util.h"
+#include "util/mapped_file.h"
+
+struct CacheEntry {
+	std::filesystem::file_time_type modified;
+
+	std::weak_ptr<CachedSample const> sample;
+
+	std::shared_ptr<std::mutex> loading = std::make_shared<std::mutex>(); // Held while the file is decoded, so concurrent requests for it wait instead of decoding it again
+};
+
+static std::mutex cache_mutex;
+static std::unordered_map<std::string, CacheEntry> cache; // Keyed by canonical path
+
+// Reduces the waveform to at most OVERVIEW_SIZE points by repeatedly halving it
+static void build_overview(CachedSample & sample) {
+	if (sample.streamed) {
+		sample.overview = sample.streamed->get_overview(CachedSample::OVERVIEW_SIZE);
+	} else {
+		std::vector<Sample> frames(sample.length);
+		sample.samples.decode(0, sample.length, frames.data());
+
+		sample.overview.resize(sample.length);
+
+		for (int i = 0; i < sample.length; i++) sample.overview[i] = 0.5f * (frames[i].left + frames[i].right);
+
+		auto num_samples = sample.overview.size();
+
+		while (num_samples > CachedSample::OVERVIEW_SIZE) {
+			for (int i = 0; i < num_samples; i += 2) {
+				auto first  = sample.overview[i];
+				auto second = sample.overview[i + 1];
+
+				auto diff = std::abs(first - second);
+
+				if (diff > 0.2f) {
+					// Choose the sample with largest absolute amplitude
+					if (std::abs(first) > std::abs(second)) {
+						sample.overview[i/2] = first;
+					} else {
+						sample.overview[i/2] = second;
+					}
+				} else {
+					// Average the two samples
+					sample.overview[i/2] = 0.5f * (first + second);
+				}
+			}
+
+			num_samples /= 2;
+		}
+
+		sample.overview.resize(num_samples);
+	}
+
+	for (auto value : sample.overview) {
+		sample.overview_max = std::max(sample.overview_max, std::abs(value));
+	}
+}
+
+std::shared_ptr<CachedSample const> sample_cache::load(char const * filename) {
+	std::error_code error;
+
+	auto path     = std::filesystem::canonical(filename, error);
+	auto modified = error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, error);
+
+	if (error) {
+		printf("ERROR: Unable to load sample '%s'!\n", filename);
+		return nullptr;
+	}
+
+	auto key = path.string();
+
+	auto find_cached = [&]() -> std::shared_ptr<CachedSample const> {
+		auto entry = cache.find(key);
+		if (entry != cache.end() && entry->second.modified == modified) return entry->second.sample.lock();
+
+		return nullptr;
+	};
+
+	std::shared_ptr<std::mutex> loading;
+
+	{
+		std::lock_guard lock(cache_mutex);
+
+		// Forget samples that are no longer used by anyone (unless they are still being loaded)
+		std::erase_if(cache, [](auto const & entry) { return entry.second.sample.expired() && entry.second.loading.use_count() == 1; });
+
+		if (auto sample = find_cached()) return sample;
+
+		loading = cache[key].loading;
+	}
+
+	// Decode outside of the cache lock, so that other files can be looked up and loaded in the meantime
+	std::lock_guard lock_loading(*loading);
+
+	{
+		std::lock_guard lock(cache_mutex);
+
+		// Another thread may have loaded the file while this one was waiting
+		if (auto sample = find_cached()) return sample;
+	}
+
+	auto sample = std::make_shared<CachedSample>();
+	sample->filename = key;
+
+	std::optional<util::WavInfo> info;
+
+	// Maps the file and keeps it in its stored format (or streams it), only possible for formats the WAV parser supports at SAMPLE_RATE
+	auto load_native = [&](char const * filename) {
+		MappedFile file;
+		if (!file.open(filename)) return false;
+
+		info = util::parse_wav_header(file.data(), file.size());
+		if (!info.has_value() || info->sample_rate != SAMPLE_RATE) return false;
+
+		if (info->num_frames > STREAMING_THRESHOLD) sample->streamed = streaming::load(filename);
+
+		if (!sample->streamed) sample->samples = SampleBuffer::from_wav(info.value(), file.data());
+
+		return true;
+	};
+
+	auto loaded = load_native(key.c_str());
+
+	if (!loaded) {
+		// Samples at other sample rates are converted once, the converted file is a float WAV at SAMPLE_RATE that loads natively like any other
+		// A converted file that does not load is converted again
+		auto converted = util::get_converted_filename(key.c_str());
+
+		auto needs_conversion = info.has_value() || util::file_exists(converted.c_str());
+
+		if (needs_conversion && util::convert_wav(key.c_str())) {
+			loaded = load_native(converted.c_str()) || (util::convert_wav(key.c_str(), true) && load_native(converted.c_str()));
+		}
+	}
+
+	if (!loaded) {
+		// Let SDL deal with the formats the WAV parser does not support
+		sample->samples = SampleBuffer::from_samples(util::load_wav(key.c_str()));
+	}
+
+	sample->length = sample->streamed ? sample->streamed->num_frames() : sample->samples.length;
+
+	if (sample->length == 0) return nullptr;
+
+	build_overview(*sample);
+
+	std::lock_guard lock(cache_mutex);
+
+	auto & entry = cache[key];
+	entry.modified = modified;
+	entry.sample   = sample;
+
+	return sample;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sample.h"
+#include "streaming.h"
+#include "sample_buffer.h"
+
+// Sample loaded from disk, shared by all Components that use the same file
+// Immutable once it has been handed out, so it can be read without locking
+struct CachedSample {
+	static constexpr auto OVERVIEW_SIZE = 512;
+
+	std::string filename; // Canonical path
+
+	SampleBuffer samples; // Empty if the sample is streamed from disk
+	std::shared_ptr<streaming::StreamedSample> streamed;
+
+	int length = 0; // In frames
+
+	std::vector<float> overview; // Mono waveform of at most OVERVIEW_SIZE points, used for display
+	float              overview_max = 0.001f;
+};
+
+namespace sample_cache {
+	inline constexpr auto STREAMING_THRESHOLD = 30 * SAMPLE_RATE; // Samples with more frames than this are streamed from disk rather than loaded into memory
+
+	// Returns the sample stored in the given file, which is only loaded if it is not in the cache yet or was modified since
+	// The cache only holds weak references, a sample is freed as soon as the last Component using it lets go of it
+	// Returns null if the file could not be loaded
+	std::shared_ptr<CachedSample const> load(char const * filename);
+}
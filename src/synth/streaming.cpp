@@ -0,0 +1,310 @@
+#include "streaming.h"
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+using namespace std::chrono_literals;
+
+namespace streaming {
+	// Ring buffer of one Stream
+	// Only the audio thread moves a Channel out of FREE and only the I/O thread moves it back into FREE,
+	// so the I/O thread never writes into a Channel that has already been handed to another Stream
+	struct Channel {
+		enum struct State { FREE, ACTIVE, RELEASED };
+
+		std::atomic<State> state = State::FREE;
+
+		// Only set while the Channel is not FREE, in which case the Stream that owns the Channel keeps the sample alive
+		// The Stream releases the Channel before it lets go of the sample, and the I/O thread only evicts samples after it is done filling
+		StreamedSample * sample = nullptr;
+
+		std::atomic<int> read_frame  = 0; // Frames before this one may be overwritten
+		std::atomic<int> write_frame = 0; // Frames before this one are available
+
+		std::unique_ptr<Sample[]> ring;
+	};
+
+	struct Streamer {
+		static inline Channel channels[MAX_STREAMS];
+
+		static inline std::mutex samples_mutex; // Protects samples, never taken by the audio thread
+		static inline std::vector<std::shared_ptr<StreamedSample>> samples;
+
+		static inline std::atomic<unsigned> use_counter = 0;
+
+		static inline std::atomic<size_t> memory_budget = DEFAULT_MEMORY_BUDGET;
+		static inline std::atomic<size_t> memory_usage  = 0;
+
+		static inline std::atomic<bool> running = false;
+		static inline std::thread       thread;
+
+		static size_t head_size(StreamedSample const & sample) {
+			return size_t(std::min(HEAD_FRAMES, sample.num_frames())) * sizeof(Sample);
+		}
+
+		static void load_head(StreamedSample & sample) {
+			sample.head.resize(std::min(HEAD_FRAMES, sample.num_frames()));
+			util::decode_wav_frames(sample.info, sample.file.data(), 0, int(sample.head.size()), sample.head.data());
+		}
+
+		// Decodes the next chunk of frames into the ring buffer, returns false if there was nothing to do
+		static bool fill(Channel & channel) {
+			auto const & sample = *channel.sample;
+
+			auto read  = channel.read_frame .load(std::memory_order_acquire);
+			auto write = channel.write_frame.load(std::memory_order_relaxed);
+
+			// The Stream has overtaken the I/O thread, there is no point in decoding frames it has already skipped
+			if (write < read) write = read;
+
+			auto end   = std::min(read + RING_FRAMES, sample.num_frames());
+			auto count = std::min(end - write, CHUNK_FRAMES);
+
+			if (count <= 0) return false;
+
+			// Decode in two parts if the chunk wraps around the end of the ring buffer
+			auto offset     = write & (RING_FRAMES - 1);
+			auto count_head = std::min(count, RING_FRAMES - offset);
+
+			util::decode_wav_frames(sample.info, sample.file.data(), write,              count_head,         &channel.ring[offset]);
+			util::decode_wav_frames(sample.info, sample.file.data(), write + count_head, count - count_head, &channel.ring[0]);
+
+			channel.write_frame.store(write + count, std::memory_order_release);
+
+			return true;
+		}
+
+		// Keeps the resident heads within the memory budget by evicting the least recently used ones
+		// Evicted heads that have been played since are brought back in once there is room again
+		static void manage_memory() {
+			std::lock_guard lock(samples_mutex);
+
+			// Samples that are only referenced from here are no longer used by any Component
+			std::erase_if(samples, [](auto const & sample) { return sample.use_count() == 1; });
+
+			size_t usage = 0;
+
+			for (auto const & sample : samples) {
+				if (sample->head_users.load() >= 0) usage += head_size(*sample);
+			}
+
+			auto budget = memory_budget.load();
+
+			if (usage > budget) {
+				std::vector<StreamedSample *> candidates;
+
+				for (auto const & sample : samples) {
+					if (sample->head_users.load() >= 0) candidates.push_back(sample.get());
+				}
+
+				std::sort(candidates.begin(), candidates.end(), [](auto a, auto b) { return a->last_used.load() < b->last_used.load(); });
+
+				for (auto sample : candidates) {
+					if (usage <= budget) break;
+
+					// Heads that are still being read from cannot be evicted
+					auto expected = 0;
+					if (!sample->head_users.compare_exchange_strong(expected, -1)) continue;
+
+					usage -= head_size(*sample);
+
+					sample->evicted_at = use_counter.load();
+					std::vector<Sample>().swap(sample->head);
+				}
+			} else {
+				for (auto const & sample : samples) {
+					if (sample->head_users.load() >= 0 || sample->last_used.load() <= sample->evicted_at) continue;
+
+					auto size = head_size(*sample);
+					if (usage + size > budget) continue;
+
+					load_head(*sample);
+					sample->head_users.store(0, std::memory_order_release);
+
+					usage += size;
+				}
+			}
+
+			memory_usage.store(usage);
+		}
+
+		static void thread_main() {
+			while (running.load()) {
+				auto busy = false;
+
+				for (auto & channel : channels) {
+					switch (channel.state.load(std::memory_order_acquire)) {
+						case Channel::State::FREE: break;
+
+						case Channel::State::ACTIVE: busy |= fill(channel); break;
+
+						case Channel::State::RELEASED: {
+							channel.sample = nullptr;
+							channel.state.store(Channel::State::FREE, std::memory_order_release);
+							break;
+						}
+					}
+				}
+
+				manage_memory();
+
+				if (!busy) std::this_thread::sleep_for(1ms);
+			}
+		}
+	};
+}
+
+std::vector<float> streaming::StreamedSample::get_overview(int num_points) const {
+	static constexpr auto PROBES_PER_POINT = 16;
+
+	std::vector<float> overview(num_points);
+
+	auto frames_per_point = double(num_frames()) / double(num_points);
+
+	for (int p = 0; p < num_points; p++) {
+		auto first = int(double(p)     * frames_per_point);
+		auto last  = int(double(p + 1) * frames_per_point);
+
+		auto step = std::max((last - first) / PROBES_PER_POINT, 1);
+
+		// Keep the probe with the largest absolute amplitude
+		for (int i = first; i < last; i += step) {
+			Sample frame;
+			util::decode_wav_frames(info, file.data(), i, 1, &frame);
+
+			auto value = 0.5f * (frame.left + frame.right);
+			if (std::abs(value) > std::abs(overview[p])) overview[p] = value;
+		}
+	}
+
+	return overview;
+}
+
+streaming::Stream & streaming::Stream::operator=(Stream && other) noexcept {
+	if (this != &other) {
+		close();
+
+		sample      = std::move(other.sample);
+		channel     = other.channel;
+		head_frames = other.head_frames;
+
+		other.channel     = nullptr;
+		other.head_frames = 0;
+	}
+
+	return *this;
+}
+
+void streaming::Stream::open(std::shared_ptr<StreamedSample> const & sample_to_stream) {
+	close();
+
+	sample = sample_to_stream;
+	sample->last_used.store(++Streamer::use_counter);
+
+	// Try to keep the head alive for as long as this Stream is open
+	auto users = sample->head_users.load();
+	while (users >= 0 && !sample->head_users.compare_exchange_weak(users, users + 1)) { }
+
+	head_frames = users >= 0 ? int(sample->head.size()) : -1;
+
+	auto first_frame = std::max(head_frames, 0);
+	if (first_frame >= sample->num_frames()) return;
+
+	for (auto & c : Streamer::channels) {
+		if (c.state.load(std::memory_order_acquire) != Channel::State::FREE) continue;
+
+		c.sample = sample.get();
+		c.read_frame .store(first_frame, std::memory_order_relaxed);
+		c.write_frame.store(first_frame, std::memory_order_relaxed);
+		c.state.store(Channel::State::ACTIVE, std::memory_order_release);
+
+		channel = &c;
+		return;
+	}
+
+	printf("WARNING: All %i streams are in use, '%s' will only play its first %i frames!\n", MAX_STREAMS, sample->filename.c_str(), first_frame);
+}
+
+void streaming::Stream::close() {
+	if (sample == nullptr) return;
+
+	if (head_frames >= 0) sample->head_users.fetch_sub(1);
+	if (channel) channel->state.store(Channel::State::RELEASED, std::memory_order_release);
+
+	// The sample is let go of last, it may be the last reference other than the one held by the I/O thread
+	sample      = nullptr;
+	channel     = nullptr;
+	head_frames = 0;
+}
+
+Sample streaming::Stream::get_frame(int index) const {
+	if (index < head_frames) return sample->head[index];
+
+	if (channel && index < channel->write_frame.load(std::memory_order_acquire)) {
+		return channel->ring[index & (RING_FRAMES - 1)];
+	}
+
+	return 0.0f;
+}
+
+void streaming::Stream::advance(float position) {
+	if (channel) channel->read_frame.store(int(position), std::memory_order_release);
+}
+
+void streaming::open() {
+	for (auto & channel : Streamer::channels) {
+		channel.ring = std::make_unique<Sample[]>(RING_FRAMES);
+	}
+
+	Streamer::running = true;
+	Streamer::thread  = std::thread(Streamer::thread_main);
+}
+
+void streaming::close() {
+	Streamer::running = false;
+	if (Streamer::thread.joinable()) Streamer::thread.join();
+
+	std::lock_guard lock(Streamer::samples_mutex);
+	Streamer::samples.clear();
+}
+
+std::shared_ptr<streaming::StreamedSample> streaming::load(char const * filename) {
+	auto sample = std::make_shared<StreamedSample>();
+	sample->filename = filename;
+
+	if (!sample->file.open(filename)) return nullptr;
+
+	auto info = util::parse_wav_header(sample->file.data(), sample->file.size());
+	if (!info.has_value()) {
+		printf("ERROR: Unable to stream sample '%s'!\n", filename);
+		return nullptr;
+	}
+
+	if (info->sample_rate != SAMPLE_RATE) {
+		printf("ERROR: Sample '%s' has a sample rate of %i! Only %i is supported\n", filename, info->sample_rate, SAMPLE_RATE);
+		return nullptr;
+	}
+
+	sample->info = info.value();
+
+	Streamer::load_head(*sample);
+
+	std::lock_guard lock(Streamer::samples_mutex);
+	Streamer::samples.push_back(sample);
+
+	return sample;
+}
+
+void streaming::set_memory_budget(size_t bytes) {
+	Streamer::memory_budget.store(bytes);
+}
+
+size_t streaming::get_memory_budget() {
+	return Streamer::memory_budget.load();
+}
+
+size_t streaming::get_memory_usage() {
+	return Streamer::memory_usage.load();
+}
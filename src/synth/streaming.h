@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "sample.h"
+
+#include "util/wav.h"
+#include "util/mapped_file.h"
+
+// Samples that are too long to keep in memory are played directly from disk
+// Only the first HEAD_FRAMES of every sample stay resident, which covers the time it takes the
+// background I/O thread to start filling the ring buffer of a newly started Stream
+namespace streaming {
+	inline constexpr auto HEAD_FRAMES  = SAMPLE_RATE / 4; // 250 ms
+	inline constexpr auto RING_FRAMES  = 1 << 15;         // Read ahead of every Stream, must be a power of two
+	inline constexpr auto CHUNK_FRAMES = 4096;            // Maximum number of frames the I/O thread decodes at once
+	inline constexpr auto MAX_STREAMS  = 64;              // Maximum number of Streams playing at the same time
+
+	inline constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(256) << 20; // In bytes, applies to the resident heads
+
+	struct StreamedSample {
+		std::string   filename;
+		MappedFile    file;
+		util::WavInfo info;
+
+		int num_frames() const { return info.num_frames; }
+
+		// Mono waveform overview with num_points points, probes the file sparsely so it does not have to read all of it
+		std::vector<float> get_overview(int num_points) const;
+
+	private:
+		std::vector<Sample> head; // Decoded first frames, empty while evicted
+
+		std::atomic<int>      head_users = 0; // Number of Streams reading from the head, -1 while the head is evicted
+		std::atomic<unsigned> last_used  = 0; // Value of the global use counter when the last Stream was opened
+		unsigned              evicted_at = 0;
+
+		friend struct Stream;
+		friend struct Streamer;
+	};
+
+	// Plays a StreamedSample from the start, typically owned by a Voice
+	// Opening and closing never block or allocate, so both can happen on the audio thread
+	// The Stream shares ownership of its sample, so the sample outlives the Stream even if the Component that loaded it lets go of it first
+	struct Stream {
+		Stream() = default;
+
+		Stream(Stream const &) = delete;
+		Stream & operator=(Stream const &) = delete;
+
+		Stream(Stream && other) noexcept { *this = std::move(other); }
+		Stream & operator=(Stream && other) noexcept;
+
+		~Stream() { close(); }
+
+		void open(std::shared_ptr<StreamedSample> const & sample);
+		void close();
+
+		bool is_open() const { return sample != nullptr; }
+
+		// Frames that have not been streamed in yet (underrun) are silent
+		Sample get_frame(int index) const;
+
+		// Frames before the given position will not be requested again, which frees up their space in the ring buffer
+		void advance(float position);
+
+	private:
+		std::shared_ptr<StreamedSample> sample;
+
+		struct Channel * channel = nullptr; // Ring buffer shared with the I/O thread, null if the head covers the whole sample or no Channel was free
+
+		int head_frames = 0; // -1 if the head was evicted, in which case everything comes from the ring buffer
+	};
+
+	void open();
+	void close();
+
+	// Maps the file and decodes its head, returns null if the file cannot be streamed
+	std::shared_ptr<StreamedSample> load(char const * filename);
+
+	void   set_memory_budget(size_t bytes);
+	size_t get_memory_budget();
+	size_t get_memory_usage();
+}
@@ -6,6 +6,7 @@
 #include <ImGui/imgui.h>
 
 #include "knob.h"
+#include "streaming.h"
 
 void Synth::update(Sample buf[BLOCK_SIZE]) {
 	for (auto const & component : components) {
@@ -32,6 +33,15 @@ void Synth::update(Sample buf[BLOCK_SIZE]) {
 	for (int i = 0; i < BLOCK_SIZE; i++) buf[i] *= settings.master_volume;
 
 	note_events.clear();
+
+	if (loading_assets) {
+		auto ready = std::all_of(components.begin(), components.end(), [](auto const & component) { return component->is_ready(); });
+
+		if (ready) {
+			load_timings.assets = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - open_time).count();
+			loading_assets = false;
+		}
+	}
 }
 
 void Synth::render() {
@@ -80,6 +90,14 @@ void Synth::render() {
 
 	if (ImGui::Begin("Settings")) {
 		ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+		ImGui::Text("Streaming: %.1f / %.1f MB", float(streaming::get_memory_usage()) / float(1 << 20), float(streaming::get_memory_budget()) / float(1 << 20));
+
+		ImGui::Text("Load: parse %.1f, construct %.1f, connect %.1f, order %.1f ms", load_timings.parse, load_timings.construct, load_timings.connect, load_timings.order);
+		if (loading_assets) {
+			ImGui::Text("Assets: loading");
+		} else {
+			ImGui::Text("Assets: %.1f ms after opening", load_timings.assets);
+		}
 
 		settings.tempo        .render();
 		settings.master_volume.render();
@@ -91,8 +109,11 @@ void Synth::render() {
 		for (auto const & component : components) {
 			auto osc = dynamic_cast<OscillatorComponent    *>(component.get()); if (osc) osc->clear();
 			auto fm  = dynamic_cast<FMComponent            *>(component.get()); if (fm)  fm ->clear();
+			auto fm6 = dynamic_cast<FM6Component           *>(component.get()); if (fm6) fm6->clear();
+			auto fm8 = dynamic_cast<FM8Component           *>(component.get()); if (fm8) fm8->clear();
 			auto add = dynamic_cast<AdditiveSynthComponent *>(component.get()); if (add) add->clear();
 			auto smp = dynamic_cast<SamplerComponent       *>(component.get()); if (smp) smp->clear();
+			auto wav = dynamic_cast<WavetableComponent     *>(component.get()); if (wav) wav->clear();
 		}
 	}
 }
@@ -108,6 +129,8 @@ bool Synth::connect(ConnectorOut & out, ConnectorIn & in, float weight) {
 	out.others.push_back(&in);
 	in .others.push_back(std::make_pair(&out, weight));
 
+	if (building_graph) return true; // Validated by open_file() once the whole graph is in place
+
 	auto success = compute_update_order();
 
 	if (!success) {
@@ -245,8 +268,11 @@ void Synth::render_menu() {
 
 			if (ImGui::MenuItem("Oscillator")) add_component<OscillatorComponent>();
 			if (ImGui::MenuItem("FM"))         add_component<FMComponent>();
+			if (ImGui::MenuItem("FM 6-Op"))    add_component<FM6Component>();
+			if (ImGui::MenuItem("FM 8-Op"))    add_component<FM8Component>();
 			if (ImGui::MenuItem("Additive"))   add_component<AdditiveSynthComponent>();
 			if (ImGui::MenuItem("Sampler"))    add_component<SamplerComponent>();
+			if (ImGui::MenuItem("Wavetable"))  add_component<WavetableComponent>();
 			
 			ImGui::Separator();
 
@@ -259,12 +285,14 @@ void Synth::render_menu() {
 			if (ImGui::MenuItem("Filter"))      add_component<FilterComponent>();
 			if (ImGui::MenuItem("Delay"))       add_component<DelayComponent>();
 			if (ImGui::MenuItem("Reverb"))      add_component<ReverbComponent>();
+			if (ImGui::MenuItem("Convolution")) add_component<ConvolutionComponent>();
 			if (ImGui::MenuItem("Flanger"))     add_component<FlangerComponent>();
 			if (ImGui::MenuItem("Phaser"))      add_component<PhaserComponent>();
 			if (ImGui::MenuItem("Distortion"))  add_component<DistortionComponent>();
 			if (ImGui::MenuItem("Bit Crusher")) add_component<BitCrusherComponent>();
 			if (ImGui::MenuItem("Equalizer"))   add_component<EqualizerComponent>();
 			if (ImGui::MenuItem("Compressor"))  add_component<CompressorComponent>();
+			if (ImGui::MenuItem("Multiband"))   add_component<MultibandCompressorComponent>();
 			if (ImGui::MenuItem("Vocoder"))     add_component<VocoderComponent>();
 			
 			ImGui::Separator();
@@ -580,8 +608,23 @@ Component * try_add_component(Synth & synth, std::string const & name, int id) {
 void Synth::open_file(char const * filename) {
 	printf("Opening '%s'\n", filename);
 
+	using Clock = std::chrono::high_resolution_clock;
+
+	open_time = Clock::now();
+
+	// Returns the time in ms since the start of the current phase and starts the next one
+	auto phase_start = open_time;
+	auto end_phase = [&phase_start]() {
+		auto now = Clock::now();
+		auto duration = std::chrono::duration<float, std::milli>(now - phase_start).count();
+		phase_start = now;
+		return duration;
+	};
+
 	auto parser = json::Parser(filename);
 
+	load_timings.parse = end_phase();
+
 	components.clear();
 	speakers.clear();
 
@@ -594,11 +637,15 @@ void Synth::open_file(char const * filename) {
 	
 	auto max_id = -1;
 
+	std::unordered_map<int, Component *> components_by_id; // Used to find Component by its ID in O(1) time
+	std::vector<json::Object const *>    connection_objects;
+
+	// Build the whole graph first, the update order is computed only once at the end
+	building_graph = true;
+
 	if (parser.root->type == json::JSON::Type::OBJECT) {
 		auto json = static_cast<json::Object const *>(parser.root.get()); 
 
-		std::unordered_map<int, Component *> components_by_id; // Used to find Component by its ID in O(1) time
-
 		for (auto const & object : json->attributes) {
 			assert(object->type == json::JSON::Type::OBJECT);
 			auto obj = static_cast<json::Object const *>(object.get());
@@ -607,28 +654,7 @@ void Synth::open_file(char const * filename) {
 				settings.tempo        .deserialize(*obj);
 				settings.master_volume.deserialize(*obj);
 			} else if (obj->name == "Connection") {
-				auto id_out     = obj->find_int("component_out", -1);
-				auto id_in      = obj->find_int("component_in",  -1);
-				auto offset_out = obj->find_int("offset_out");
-				auto offset_in  = obj->find_int("offset_in");
-				auto weight     = obj->find_float("weight");
-
-				auto component_out = components_by_id[id_out];
-				auto component_in  = components_by_id[id_in];
-
-				if (component_out == nullptr || component_in == nullptr) {
-					printf("WARNING: Failed to load connection %i <-> %i!\n", id_out, id_in);
-					continue;
-				}
-
-				auto & connector_out = component_out->outputs[offset_out];
-				auto & connector_in  = component_in ->inputs [offset_in];
-
-				auto valid = connect(connector_out, connector_in, weight);
-				if (!valid) {
-					printf("WARNING: Failed to connect %i <-> %i!\n", id_out, id_in);
-					continue;
-				}
+				connection_objects.push_back(obj); // Connected once all Components exist
 			} else {
 				auto obj_id = obj->find<json::ValueInt const>("id");
 				if (!obj_id) {
@@ -654,12 +680,64 @@ void Synth::open_file(char const * filename) {
 		}
 	}
 
+	load_timings.construct = end_phase();
+
+	auto connect_all = [&]() {
+		for (auto obj : connection_objects) {
+			auto id_out     = obj->find_int("component_out", -1);
+			auto id_in      = obj->find_int("component_in",  -1);
+			auto offset_out = obj->find_int("offset_out");
+			auto offset_in  = obj->find_int("offset_in");
+			auto weight     = obj->find_float("weight");
+
+			auto component_out = components_by_id[id_out];
+			auto component_in  = components_by_id[id_in];
+
+			if (component_out == nullptr || component_in == nullptr) {
+				printf("WARNING: Failed to load connection %i <-> %i!\n", id_out, id_in);
+				continue;
+			}
+
+			auto & connector_out = component_out->outputs[offset_out];
+			auto & connector_in  = component_in ->inputs [offset_in];
+
+			auto valid = connect(connector_out, connector_in, weight);
+			if (!valid) {
+				printf("WARNING: Failed to connect %i <-> %i!\n", id_out, id_in);
+				continue;
+			}
+		}
+	};
+
+	connect_all();
+
+	building_graph = false;
+
+	load_timings.connect = end_phase();
+
 	auto success = compute_update_order();
-	assert(success);
+
+	// Only a file that was edited by hand can contain a cycle, in which case the connections are validated one at a time
+	if (!success) {
+		printf("WARNING: '%s' contains a cycle, some connections will be dropped!\n", filename);
+
+		for (auto const & component : components) {
+			for (auto & input  : component->inputs)  input .others.clear();
+			for (auto & output : component->outputs) output.others.clear();
+		}
+
+		success = compute_update_order();
+		assert(success);
+
+		connect_all();
+	}
+
+	load_timings.order = end_phase();
 
 	unique_component_id = max_id + 1;
 
-	just_loaded = true;
+	just_loaded    = true;
+	loading_assets = true; // Assets keep loading in the background, update() measures when they are all ready
 }
 
 void Synth::save_file(char const * filename) const {
@@ -1,5 +1,6 @@
 #pragma once
 #include <set>
+#include <chrono>
 
 #include "components/components.h"
 
@@ -24,6 +25,15 @@ struct Synth {
 	FileDialog mutable file_dialog;
 	bool just_loaded = false;
 
+	// Time in ms spent in every phase of the most recent open_file(), shown in the Settings window
+	struct {
+		float parse     = 0.0f;
+		float construct = 0.0f;
+		float connect   = 0.0f;
+		float order     = 0.0f;
+		float assets    = 0.0f; // From the start of open_file() until every Component has loaded its files in the background
+	} load_timings;
+
 	Synth() {
 		open_file("projects/default.json");
 	}
@@ -42,8 +52,10 @@ struct Synth {
 
 		auto result = static_cast<T *>(components.emplace_back(std::move(component)).get());
 
-		auto success = compute_update_order();
-		assert(success);
+		if (!building_graph) {
+			auto success = compute_update_order();
+			assert(success);
+		}
 
 		return result;
 	}
@@ -76,6 +88,12 @@ private:
 	
 	Component * component_to_be_removed = nullptr;
 
+	// While set, add_component() and connect() do not compute the update order, open_file() computes it once at the end
+	bool building_graph = false;
+
+	bool loading_assets = false; // Set until all Components of the most recently opened file are ready
+	std::chrono::high_resolution_clock::time_point open_time;
+
 	bool compute_update_order();
 
 	void render_menu();
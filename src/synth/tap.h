@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "sample.h"
+#include "connector.h"
+
+#include "util/util.h"
+
+// Lock-free single producer single consumer history of the most recent CAPACITY samples
+// Visualizers push their input into a Tap in update() and do all analysis on the UI side in render(),
+// the audio side never waits for the reader: if the reader falls behind, old samples are overwritten and reads of them fail
+template<int CAPACITY>
+struct Tap {
+	static_assert(util::is_power_of_two(CAPACITY) && CAPACITY > BLOCK_SIZE, "Tap capacity must be a power of two larger than a block");
+
+	// Audio side, at most BLOCK_SIZE samples at a time
+	void push(Sample const samples[], int count) {
+		assert(count <= BLOCK_SIZE);
+
+		auto pos = position.load(std::memory_order_relaxed);
+
+		for (int i = 0; i < count; i++) {
+			buffer[(pos + i) & (CAPACITY - 1)] = samples[i];
+		}
+
+		position.store(pos + count, std::memory_order_release);
+	}
+
+	// Audio side, pushes one block of the given input
+	void push(ConnectorIn const & input) {
+		Sample samples[BLOCK_SIZE];
+		for (int i = 0; i < BLOCK_SIZE; i++) samples[i] = input.get_sample(i);
+
+		push(samples, BLOCK_SIZE);
+	}
+
+	// Total number of samples pushed so far
+	int64_t get_position() const { return position.load(std::memory_order_acquire); }
+
+	// Copies count samples starting at absolute position from, samples before the first push read as silence
+	// Returns false if the samples have not been pushed yet, or if (part of) them were overwritten before the copy was done
+	bool read(int64_t from, int count, Sample out[]) const {
+		if (from + count > get_position()) return false;
+
+		for (int i = 0; i < count; i++) {
+			out[i] = buffer[(from + i) & (CAPACITY - 1)];
+		}
+
+		// A push that is in progress may overwrite up to BLOCK_SIZE samples beyond the current position
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return from >= position.load(std::memory_order_relaxed) + BLOCK_SIZE - CAPACITY;
+	}
+
+	// Copies the most recent count samples
+	bool read_latest(int count, Sample out[]) const {
+		return read(get_position() - count, count, out);
+	}
+
+private:
+	Sample buffer[CAPACITY] = { };
+
+	std::atomic<int64_t> position = 0;
+};
@@ -0,0 +1,75 @@
+#include "mapped_file.h"
+
+#define VC_EXTRALEAN
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <cstdio>
+
+MappedFile & MappedFile::operator=(MappedFile && other) noexcept {
+	if (this != &other) {
+		close();
+
+		file    = other.file;
+		mapping = other.mapping;
+		view    = other.view;
+		length  = other.length;
+
+		other.file    = nullptr;
+		other.mapping = nullptr;
+		other.view    = nullptr;
+		other.length  = 0;
+	}
+
+	return *this;
+}
+
+bool MappedFile::open(char const * filename) {
+	close();
+
+	auto handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		printf("ERROR: Unable to open file '%s'!\n", filename);
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+		printf("ERROR: Unable to map empty file '%s'!\n", filename);
+		CloseHandle(handle);
+		return false;
+	}
+
+	auto map = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (map == nullptr) {
+		printf("ERROR: Unable to create file mapping for '%s'!\n", filename);
+		CloseHandle(handle);
+		return false;
+	}
+
+	auto ptr = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (ptr == nullptr) {
+		printf("ERROR: Unable to map view of file '%s'!\n", filename);
+		CloseHandle(map);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file    = handle;
+	mapping = map;
+	view    = ptr;
+	length  = size_t(file_size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close() {
+	if (view)    UnmapViewOfFile(view);
+	if (mapping) CloseHandle(mapping);
+	if (file)    CloseHandle(file);
+
+	file    = nullptr;
+	mapping = nullptr;
+	view    = nullptr;
+	length  = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+// Read only view of a whole file, pages are brought into memory by the OS on first access
+struct MappedFile {
+	MappedFile() = default;
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile & operator=(MappedFile const &) = delete;
+
+	MappedFile(MappedFile && other) noexcept { *this = static_cast<MappedFile &&>(other); }
+	MappedFile & operator=(MappedFile && other) noexcept;
+
+	~MappedFile() { close(); }
+
+	bool open(char const * filename);
+	void close();
+
+	bool is_open() const { return view != nullptr; }
+
+	unsigned char const * data() const { return static_cast<unsigned char const *>(view); }
+	size_t                size() const { return length; }
+
+private:
+	void * file    = nullptr;
+	void * mapping = nullptr;
+
+	void const * view   = nullptr;
+	size_t       length = 0;
+};
@@ -0,0 +1,316 @@
+#pragma once
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+// Thin wrapper around 4-wide SSE registers
+// Define SIMD_SCALAR to force the portable scalar implementation
+#if !defined(SIMD_SCALAR) && (defined(_M_X64) || defined(__SSE2__))
+	#define SIMD_SSE 1
+	#include <immintrin.h>
+#else
+	#define SIMD_SSE 0
+#endif
+
+namespace simd {
+	inline constexpr auto WIDTH = 4;
+
+	struct float4 {
+#if SIMD_SSE
+		__m128 data;
+
+		float4()                                 : data(_mm_setzero_ps()) { }
+		float4(__m128 data)                      : data(data) { }
+		float4(float f)                          : data(_mm_set1_ps(f)) { }
+		float4(float a, float b, float c, float d) : data(_mm_setr_ps(a, b, c, d)) { }
+
+		static float4 load (float const * ptr) { return _mm_load_ps (ptr); } // Requires 16 byte alignment
+		static float4 loadu(float const * ptr) { return _mm_loadu_ps(ptr); }
+
+		void store (float * ptr) const { _mm_store_ps (ptr, data); } // Requires 16 byte alignment
+		void storeu(float * ptr) const { _mm_storeu_ps(ptr, data); }
+
+		static float4 from_mask_bits(unsigned bits) {
+			return _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(_mm_set1_epi32(bits), _mm_setr_epi32(1, 2, 4, 8)), _mm_setzero_si128()));
+		}
+#else
+		float data[WIDTH];
+
+		float4()                                   : data { 0.0f, 0.0f, 0.0f, 0.0f } { }
+		float4(float f)                            : data { f, f, f, f } { }
+		float4(float a, float b, float c, float d) : data { a, b, c, d } { }
+
+		static float4 load (float const * ptr) { return { ptr[0], ptr[1], ptr[2], ptr[3] }; }
+		static float4 loadu(float const * ptr) { return { ptr[0], ptr[1], ptr[2], ptr[3] }; }
+
+		void store (float * ptr) const { std::memcpy(ptr, data, sizeof(data)); }
+		void storeu(float * ptr) const { std::memcpy(ptr, data, sizeof(data)); }
+
+		static float4 from_mask_bits(unsigned bits) {
+			float4 result;
+			for (int i = 0; i < WIDTH; i++) {
+				auto mask = (bits & (1u << i)) ? 0xffffffffu : 0u;
+				std::memcpy(&result.data[i], &mask, sizeof(float));
+			}
+			return result;
+		}
+#endif
+		float operator[](int i) const {
+			alignas(16) float lanes[WIDTH];
+			store(lanes);
+			return lanes[i];
+		}
+
+		void operator+=(float4 const & other);
+		void operator-=(float4 const & other);
+		void operator*=(float4 const & other);
+		void operator/=(float4 const & other);
+	};
+
+#if SIMD_SSE
+	inline float4 operator+(float4 const & a, float4 const & b) { return _mm_add_ps(a.data, b.data); }
+	inline float4 operator-(float4 const & a, float4 const & b) { return _mm_sub_ps(a.data, b.data); }
+	inline float4 operator*(float4 const & a, float4 const & b) { return _mm_mul_ps(a.data, b.data); }
+	inline float4 operator/(float4 const & a, float4 const & b) { return _mm_div_ps(a.data, b.data); }
+
+	inline float4 operator-(float4 const & a) { return _mm_xor_ps(a.data, _mm_set1_ps(-0.0f)); }
+
+	// Comparisons return a mask with all bits set in the lanes where the comparison holds
+	inline float4 operator< (float4 const & a, float4 const & b) { return _mm_cmplt_ps(a.data, b.data); }
+	inline float4 operator> (float4 const & a, float4 const & b) { return _mm_cmpgt_ps(a.data, b.data); }
+	inline float4 operator<=(float4 const & a, float4 const & b) { return _mm_cmple_ps(a.data, b.data); }
+	inline float4 operator>=(float4 const & a, float4 const & b) { return _mm_cmpge_ps(a.data, b.data); }
+
+	inline float4 operator&(float4 const & a, float4 const & b) { return _mm_and_ps(a.data, b.data); }
+	inline float4 operator|(float4 const & a, float4 const & b) { return _mm_or_ps (a.data, b.data); }
+
+	inline float4 min(float4 const & a, float4 const & b) { return _mm_min_ps(a.data, b.data); }
+	inline float4 max(float4 const & a, float4 const & b) { return _mm_max_ps(a.data, b.data); }
+
+	inline float4 abs (float4 const & a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.data); }
+	inline float4 sqrt(float4 const & a) { return _mm_sqrt_ps(a.data); }
+
+	// Only valid for |a| < 2^31
+	inline float4 floor(float4 const & a) {
+		auto truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.data));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.data), _mm_set1_ps(1.0f)));
+	}
+
+	// Selects a where the mask is set and b elsewhere
+	inline float4 select(float4 const & mask, float4 const & a, float4 const & b) {
+		return _mm_or_ps(_mm_and_ps(mask.data, a.data), _mm_andnot_ps(mask.data, b.data));
+	}
+
+	inline bool any(float4 const & mask) { return _mm_movemask_ps(mask.data) != 0; }
+
+	// Interleaves the lower (a0, b0, a1, b1) or upper (a2, b2, a3, b3) halves of a and b
+	inline float4 interleave_lo(float4 const & a, float4 const & b) { return _mm_unpacklo_ps(a.data, b.data); }
+	inline float4 interleave_hi(float4 const & a, float4 const & b) { return _mm_unpackhi_ps(a.data, b.data); }
+
+	// Gathers the even (a0, a2, b0, b2) or odd (a1, a3, b1, b3) lanes of a and b, undoing interleave_lo and interleave_hi
+	inline float4 deinterleave_even(float4 const & a, float4 const & b) { return _mm_shuffle_ps(a.data, b.data, _MM_SHUFFLE(2, 0, 2, 0)); }
+	inline float4 deinterleave_odd (float4 const & a, float4 const & b) { return _mm_shuffle_ps(a.data, b.data, _MM_SHUFFLE(3, 1, 3, 1)); }
+
+	// Concatenates the lower (a0, a1, b0, b1) or upper (a2, a3, b2, b3) halves of a and b
+	inline float4 concat_lo(float4 const & a, float4 const & b) { return _mm_movelh_ps(a.data, b.data); }
+	inline float4 concat_hi(float4 const & a, float4 const & b) { return _mm_movehl_ps(b.data, a.data); }
+
+	// Concatenates the upper half of a and the lower half of b (a2, a3, b0, b1)
+	inline float4 concat_hi_lo(float4 const & a, float4 const & b) { return _mm_shuffle_ps(a.data, b.data, _MM_SHUFFLE(1, 0, 3, 2)); }
+
+	// Swaps neighbouring lanes (a1, a0, a3, a2), for interleaved complex numbers this swaps real and imaginary parts
+	inline float4 swap_pairs(float4 const & a) { return _mm_shuffle_ps(a.data, a.data, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+	inline float hsum(float4 const & a) {
+		auto shuf = _mm_shuffle_ps(a.data, a.data, _MM_SHUFFLE(2, 3, 0, 1));
+		auto sums = _mm_add_ps(a.data, shuf);
+		shuf = _mm_movehl_ps(shuf, sums);
+		return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+	}
+
+	// Splits positive a into a mantissa in [1, 2) and an integer exponent, a = mantissa * 2^exponent
+	inline float4 split_exponent(float4 const & a, float4 & mantissa) {
+		auto bits = _mm_castps_si128(a.data);
+
+		mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+		return _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	}
+
+	// 2^a for integer a in [-126, 127]
+	inline float4 exp2_int(float4 const & a) {
+		return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(a.data), _mm_set1_epi32(127)), 23));
+	}
+#else
+	template<typename Function>
+	inline float4 apply(float4 const & a, float4 const & b, Function func) {
+		float4 result;
+		for (int i = 0; i < WIDTH; i++) result.data[i] = func(a.data[i], b.data[i]);
+		return result;
+	}
+
+	template<typename Function>
+	inline float4 apply_mask(float4 const & a, float4 const & b, Function func) {
+		return apply(a, b, [func](float x, float y) {
+			auto mask = func(x, y) ? 0xffffffffu : 0u;
+			float result; std::memcpy(&result, &mask, sizeof(float));
+			return result;
+		});
+	}
+
+	template<typename Function>
+	inline float4 apply_bits(float4 const & a, float4 const & b, Function func) {
+		return apply(a, b, [func](float x, float y) {
+			unsigned bits_x; std::memcpy(&bits_x, &x, sizeof(float));
+			unsigned bits_y; std::memcpy(&bits_y, &y, sizeof(float));
+			auto bits = func(bits_x, bits_y);
+			float result; std::memcpy(&result, &bits, sizeof(float));
+			return result;
+		});
+	}
+
+	inline float4 operator+(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+	inline float4 operator-(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+	inline float4 operator*(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+	inline float4 operator/(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+
+	inline float4 operator-(float4 const & a) { return apply(a, a, [](float x, float) { return -x; }); }
+
+	inline float4 operator< (float4 const & a, float4 const & b) { return apply_mask(a, b, [](float x, float y) { return x <  y; }); }
+	inline float4 operator> (float4 const & a, float4 const & b) { return apply_mask(a, b, [](float x, float y) { return x >  y; }); }
+	inline float4 operator<=(float4 const & a, float4 const & b) { return apply_mask(a, b, [](float x, float y) { return x <= y; }); }
+	inline float4 operator>=(float4 const & a, float4 const & b) { return apply_mask(a, b, [](float x, float y) { return x >= y; }); }
+
+	inline float4 operator&(float4 const & a, float4 const & b) { return apply_bits(a, b, [](unsigned x, unsigned y) { return x & y; }); }
+	inline float4 operator|(float4 const & a, float4 const & b) { return apply_bits(a, b, [](unsigned x, unsigned y) { return x | y; }); }
+
+	inline float4 min(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return y < x ? y : x; }); }
+	inline float4 max(float4 const & a, float4 const & b) { return apply(a, b, [](float x, float y) { return y > x ? y : x; }); }
+
+	inline float4 abs  (float4 const & a) { return apply(a, a, [](float x, float) { return std::abs  (x); }); }
+	inline float4 sqrt (float4 const & a) { return apply(a, a, [](float x, float) { return std::sqrt (x); }); }
+	inline float4 floor(float4 const & a) { return apply(a, a, [](float x, float) { return std::floor(x); }); }
+
+	inline float4 select(float4 const & mask, float4 const & a, float4 const & b) {
+		float4 result;
+		for (int i = 0; i < WIDTH; i++) {
+			unsigned bits; std::memcpy(&bits, &mask.data[i], sizeof(float));
+			result.data[i] = bits ? a.data[i] : b.data[i];
+		}
+		return result;
+	}
+
+	inline bool any(float4 const & mask) {
+		for (int i = 0; i < WIDTH; i++) {
+			unsigned bits; std::memcpy(&bits, &mask.data[i], sizeof(float));
+			if (bits) return true;
+		}
+		return false;
+	}
+
+	inline float4 interleave_lo(float4 const & a, float4 const & b) { return { a.data[0], b.data[0], a.data[1], b.data[1] }; }
+	inline float4 interleave_hi(float4 const & a, float4 const & b) { return { a.data[2], b.data[2], a.data[3], b.data[3] }; }
+
+	inline float4 deinterleave_even(float4 const & a, float4 const & b) { return { a.data[0], a.data[2], b.data[0], b.data[2] }; }
+	inline float4 deinterleave_odd (float4 const & a, float4 const & b) { return { a.data[1], a.data[3], b.data[1], b.data[3] }; }
+
+	inline float4 concat_lo(float4 const & a, float4 const & b) { return { a.data[0], a.data[1], b.data[0], b.data[1] }; }
+	inline float4 concat_hi(float4 const & a, float4 const & b) { return { a.data[2], a.data[3], b.data[2], b.data[3] }; }
+	inline float4 concat_hi_lo(float4 const & a, float4 const & b) { return { a.data[2], a.data[3], b.data[0], b.data[1] }; }
+
+	inline float4 swap_pairs(float4 const & a) { return { a.data[1], a.data[0], a.data[3], a.data[2] }; }
+
+	inline float hsum(float4 const & a) { return (a.data[0] + a.data[1]) + (a.data[2] + a.data[3]); }
+
+	inline float4 split_exponent(float4 const & a, float4 & mantissa) {
+		float4 exponent;
+		for (int i = 0; i < WIDTH; i++) {
+			int e;
+			mantissa.data[i] = 2.0f * std::frexp(a.data[i], &e);
+			exponent.data[i] = float(e - 1);
+		}
+		return exponent;
+	}
+
+	inline float4 exp2_int(float4 const & a) { return apply(a, a, [](float x, float) { return std::ldexp(1.0f, int(x)); }); }
+#endif
+
+	inline void float4::operator+=(float4 const & other) { *this = *this + other; }
+	inline void float4::operator-=(float4 const & other) { *this = *this - other; }
+	inline void float4::operator*=(float4 const & other) { *this = *this * other; }
+	inline void float4::operator/=(float4 const & other) { *this = *this / other; }
+
+	inline float4 operator+(float4 const & a, float b) { return a + float4(b); }
+	inline float4 operator-(float4 const & a, float b) { return a - float4(b); }
+	inline float4 operator*(float4 const & a, float b) { return a * float4(b); }
+	inline float4 operator/(float4 const & a, float b) { return a / float4(b); }
+
+	inline float4 operator+(float a, float4 const & b) { return float4(a) + b; }
+	inline float4 operator-(float a, float4 const & b) { return float4(a) - b; }
+	inline float4 operator*(float a, float4 const & b) { return float4(a) * b; }
+	inline float4 operator/(float a, float4 const & b) { return float4(a) / b; }
+
+	// Fractional part, x - floor(x)
+	inline float4 frac(float4 const & x) { return x - floor(x); }
+
+	inline float4 lerp(float4 const & a, float4 const & b, float4 const & t) { return a + (b - a) * t; }
+
+	// Approximates sin(2 pi x), x is measured in turns rather than radians
+	// Maximum absolute error is around 1e-5
+	inline float4 sin_turns(float4 const & x) {
+		auto y = x - floor(x + 0.5f); // Wrap to [-0.5, 0.5)
+
+		// Fold to [-0.25, 0.25] using the symmetry sin(pi - z) = sin(z)
+		auto fold_pos = y >  0.25f;
+		auto fold_neg = y < -0.25f;
+		y = select(fold_pos,  0.5f - y, y);
+		y = select(fold_neg, -0.5f - y, y);
+
+		auto z  = 6.28318530718f * y;
+		auto z2 = z * z;
+
+		// Taylor series up to z^9
+		float4 p = 1.0f / 362880.0f;
+		p = p * z2 - 1.0f / 5040.0f;
+		p = p * z2 + 1.0f / 120.0f;
+		p = p * z2 - 1.0f / 6.0f;
+		p = p * z2 + 1.0f;
+
+		return z * p;
+	}
+
+	// Approximates log2(x) for positive x, zero and denormals map to -126
+	// Maximum absolute error is around 2e-5
+	inline float4 log2_fast(float4 const & x) {
+		float4 mantissa;
+		auto exponent = split_exponent(max(x, float4(FLT_MIN)), mantissa);
+
+		auto t = mantissa - 1.0f;
+
+		// Minimax polynomial for log2(1 + t) on [0, 1)
+		float4 p = 0.0463846915f;
+		p = p * t - 0.19626801f;
+		p = p * t + 0.417594419f;
+		p = p * t - 0.709662369f;
+		p = p * t + 1.44196557f;
+
+		return exponent + t * p;
+	}
+
+	// Approximates 2^x, x is clamped to [-126, 126]
+	// Maximum relative error is around 5e-6
+	inline float4 exp2_fast(float4 const & x) {
+		auto y = min(max(x, float4(-126.0f)), float4(126.0f));
+
+		auto exponent = floor(y);
+		auto t        = y - exponent;
+
+		// Minimax polynomial for 2^t - 1 on [0, 1)
+		float4 p = 0.0135812517f;
+		p = p * t + 0.0519505404f;
+		p = p * t + 0.241445511f;
+		p = p * t + 0.693018528f;
+
+		return (1.0f + t * p) * exp2_int(exponent);
+	}
+}
@@ -0,0 +1,44 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int num_threads) {
+	threads.reserve(num_threads);
+
+	for (int i = 0; i < num_threads; i++) {
+		threads.emplace_back(&ThreadPool::worker, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+
+	for (auto & thread : threads) thread.join();
+}
+
+void ThreadPool::worker() {
+	while (true) {
+		std::function<void()> job;
+
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+			if (stopping) return;
+
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+
+		job();
+	}
+}
+
+ThreadPool & util::get_thread_pool() {
+	static ThreadPool pool(std::max(1, int(std::thread::hardware_concurrency())));
+	return pool;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <queue>
+#include <vector>
+#include <memory>
+#include <future>
+#include <functional>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Fixed set of worker threads that run jobs in the order they were submitted
+struct ThreadPool {
+	ThreadPool(int num_threads);
+	~ThreadPool();
+
+	// Jobs that have not started by the time the pool is destroyed are dropped,
+	// their futures will then throw std::future_error (broken promise) when waited on
+	template<typename Function>
+	auto submit(Function func) -> std::future<std::invoke_result_t<Function>> {
+		auto task   = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(func));
+		auto future = task->get_future();
+
+		{
+			std::lock_guard lock(mutex);
+			jobs.emplace([task]() { (*task)(); });
+		}
+		condition.notify_one();
+
+		return future;
+	}
+
+private:
+	std::vector<std::thread>          threads;
+	std::queue<std::function<void()>> jobs;
+
+	std::mutex              mutex;
+	std::condition_variable condition;
+
+	bool stopping = false;
+
+	void worker();
+};
+
+namespace util {
+	// Pool shared by everything that loads files in the background, has one thread per hardware thread
+	ThreadPool & get_thread_pool();
+
+	// Non-blocking check whether a future holds a result that can be retrieved with get()
+	template<typename T>
+	bool is_ready(std::future<T> const & future) {
+		return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+}
@@ -6,9 +6,15 @@
 #include <ctime>
 #include <bit>
 #include <filesystem>
+#include <thread>
 
 #include <SDL2/SDL.h>
 
+#include "wav.h"
+#include "mapped_file.h"
+
+#include "dsp/resample.h"
+
 static unsigned wang_hash(unsigned seed) {
     seed = (seed ^ 61) ^ (seed >> 16);
     seed *= 9;
@@ -36,24 +42,6 @@ float util::randf(unsigned & seed) {
 	return rand(seed) * ONE_OVER_MAX_UINT;
 }
 
-float util::envelope(float t, float attack, float hold, float decay, float sustain) {
-	if (t < attack) {
-		return t / attack;
-	}
-	t -= attack;
-
-	if (t < hold) {
-		return 1.0f;
-	}
-	t -= hold;
-
-	if (t < decay) {
-		return util::lerp(1.0f, sustain, t / decay);
-	}
-
-	return sustain;
-};
-
 template<bool SWAP_ENDIANNESS = false, typename T>
 void wav_integral_to_float(std::vector<Sample> & samples, SDL_AudioSpec const & wav_spec, T * wav_buffer, Uint32 wav_length) {
 	samples.resize(wav_length / (wav_spec.channels * sizeof(T)));
@@ -77,7 +65,30 @@ void wav_integral_to_float(std::vector<Sample> & samples, SDL_AudioSpec const &
 	}
 }
 
-std::vector<Sample> util::load_wav(char const * filename) {
+// Samples at a different sample rate are converted when they are first loaded, the result is stored next to the original file
+std::string util::get_converted_filename(char const * filename) {
+	return std::string(filename) + "." + std::to_string(SAMPLE_RATE) + ".cache";
+}
+
+static bool is_up_to_date(std::string const & converted_filename, char const * filename) {
+	std::error_code error;
+
+	auto time_converted = std::filesystem::last_write_time(converted_filename, error); if (error) return false;
+	auto time_original  = std::filesystem::last_write_time(filename,           error); if (error) return false;
+
+	if (time_converted < time_original) return false;
+
+	// A converted file left incomplete (for instance by a crash or a full disk) would otherwise be accepted forever
+	MappedFile file;
+	if (!file.open(converted_filename.c_str())) return false;
+
+	auto info = util::parse_wav_header(file.data(), file.size());
+
+	return info.has_value() && info->sample_rate == SAMPLE_RATE && !info->truncated;
+}
+
+// Decodes a whole file through SDL, which supports more formats than util::parse_wav_header
+static std::vector<Sample> decode_wav(char const * filename, int & sample_rate) {
 	Uint32        wav_length;
 	Uint8       * wav_buffer;
 	SDL_AudioSpec wav_spec;
@@ -89,13 +100,11 @@ std::vector<Sample> util::load_wav(char const * filename) {
 
 	if (wav_spec.channels != 1 && wav_spec.channels != 2) {
 		printf("ERROR: Sample '%s' has %i channels! Should be either 1 (Mono) or 2 (Stereo)\n", filename, wav_spec.channels);
+		SDL_FreeWAV(wav_buffer);
 		return { };
 	}
 
-	if (wav_spec.freq != SAMPLE_RATE) {
-		printf("ERROR: Sample '%s' has a sample rate of %i! Only %i is supported\n", filename, wav_spec.freq, SAMPLE_RATE);
-		return { };
-	}
+	sample_rate = wav_spec.freq;
 
 	std::vector<Sample> samples;
 
@@ -134,6 +143,67 @@ std::vector<Sample> util::load_wav(char const * filename) {
 	return samples;
 }
 
+// Resamples to SAMPLE_RATE and stores the result as the converted file
+// The file is written under a temporary name first and then renamed, so that an interrupted write (or two threads converting
+// the same file at once) never leaves a truncated file behind that would look up to date
+static void store_converted(char const * filename, std::vector<Sample> & samples, int sample_rate) {
+	printf("Converting sample '%s' from %i Hz to %i Hz\n", filename, sample_rate, SAMPLE_RATE);
+
+	samples = dsp::resample(samples, sample_rate, SAMPLE_RATE);
+
+	auto converted_filename = util::get_converted_filename(filename);
+	auto temp_filename      = converted_filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	std::error_code error;
+
+	if (util::write_wav(temp_filename.c_str(), samples.data(), int(samples.size()), SAMPLE_RATE)) {
+		std::filesystem::rename(temp_filename, converted_filename, error);
+	} else {
+		error = std::make_error_code(std::errc::io_error);
+	}
+
+	if (error) {
+		std::filesystem::remove(temp_filename, error);
+		printf("WARNING: Unable to store converted sample '%s', it will be converted again next time\n", converted_filename.c_str());
+	}
+}
+
+bool util::convert_wav(char const * filename, bool force) {
+	if (!force && is_up_to_date(get_converted_filename(filename), filename)) return true;
+
+	int sample_rate = SAMPLE_RATE;
+	auto samples = decode_wav(filename, sample_rate);
+
+	if (samples.size() == 0 || sample_rate == SAMPLE_RATE) return false;
+
+	store_converted(filename, samples, sample_rate);
+
+	return is_up_to_date(get_converted_filename(filename), filename);
+}
+
+std::vector<Sample> util::load_wav(char const * filename) {
+	auto converted_filename = get_converted_filename(filename);
+
+	// Only files at a different sample rate have a converted file, so it can be used without decoding the original first
+	if (is_up_to_date(converted_filename, filename)) {
+		int sample_rate = 0;
+		auto samples = decode_wav(converted_filename.c_str(), sample_rate);
+
+		if (samples.size() > 0 && sample_rate == SAMPLE_RATE) return samples;
+
+		printf("WARNING: Unable to load converted sample '%s', converting it again\n", converted_filename.c_str());
+	}
+
+	int sample_rate = SAMPLE_RATE;
+	auto samples = decode_wav(filename, sample_rate);
+
+	if (sample_rate != SAMPLE_RATE && samples.size() > 0) {
+		store_converted(filename, samples, sample_rate);
+	}
+
+	return samples;
+}
+
 std::vector<char> util::read_file(char const * filename) {
 	FILE * file; fopen_s(&file, filename, "rb");
 
@@ -0,0 +1,189 @@
+#include "wav.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////
+// Reference: http://soundfile.sapp.org/doc/WaveFormat/ //
+//////////////////////////////////////////////////////////
+
+static constexpr uint16_t WAVE_FORMAT_PCM        = 0x0001;
+static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+static constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xfffe;
+
+template<typename T>
+static T read(unsigned char const * ptr) {
+	T value;
+	memcpy(&value, ptr, sizeof(T));
+	return value;
+}
+
+std::optional<util::WavInfo> util::parse_wav_header(unsigned char const * file, size_t size) {
+	if (size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+		printf("ERROR: File is not a RIFF WAVE file!\n");
+		return { };
+	}
+
+	bool has_format = false;
+
+	uint16_t format_tag;
+	uint16_t channels;
+	uint32_t sample_rate;
+	uint16_t block_align;
+	uint16_t bits_per_sample;
+
+	size_t offset = 12;
+
+	while (offset + 8 <= size) {
+		auto chunk_id   = file + offset;
+		auto chunk_size = size_t(read<uint32_t>(file + offset + 4));
+
+		offset += 8;
+
+		if (memcmp(chunk_id, "fmt ", 4) == 0 && chunk_size >= 16 && offset + chunk_size <= size) {
+			format_tag      = read<uint16_t>(file + offset);
+			channels        = read<uint16_t>(file + offset + 2);
+			sample_rate     = read<uint32_t>(file + offset + 4);
+			block_align     = read<uint16_t>(file + offset + 12);
+			bits_per_sample = read<uint16_t>(file + offset + 14);
+
+			// The actual format of WAVE_FORMAT_EXTENSIBLE is stored in the first two bytes of the sub format GUID
+			if (format_tag == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 26) {
+				format_tag = read<uint16_t>(file + offset + 24);
+			}
+
+			has_format = true;
+		} else if (memcmp(chunk_id, "data", 4) == 0) {
+			if (!has_format) {
+				printf("ERROR: WAV data chunk appears before the fmt chunk!\n");
+				return { };
+			}
+
+			if (channels != 1 && channels != 2) {
+				printf("ERROR: WAV files with %i channels are not supported!\n", channels);
+				return { };
+			}
+
+			WavInfo info;
+
+			if (format_tag == WAVE_FORMAT_PCM) {
+				switch (bits_per_sample) {
+					case 8:  info.format = WavInfo::Format::PCM_U8;  break;
+					case 16: info.format = WavInfo::Format::PCM_S16; break;
+					case 24: info.format = WavInfo::Format::PCM_S24; break;
+					case 32: info.format = WavInfo::Format::PCM_S32; break;
+
+					default: printf("ERROR: WAV files with %i bits per sample are not supported!\n", bits_per_sample); return { };
+				}
+			} else if (format_tag == WAVE_FORMAT_IEEE_FLOAT && bits_per_sample == 32) {
+				info.format = WavInfo::Format::FLOAT_32;
+			} else {
+				printf("ERROR: WAV format 0x%x is not supported!\n", format_tag);
+				return { };
+			}
+
+			if (block_align != channels * bits_per_sample / 8) {
+				printf("ERROR: WAV file has unexpected block alignment %i!\n", block_align);
+				return { };
+			}
+
+			// Some writers leave the size of the data chunk at zero or too large when they are interrupted
+			auto data_size = std::min(chunk_size, size - offset);
+			if (data_size == 0) data_size = size - offset;
+
+			info.channels        = channels;
+			info.sample_rate     = sample_rate;
+			info.bytes_per_frame = block_align;
+			info.num_frames      = int(std::min(data_size / block_align, size_t(INT32_MAX)));
+			info.data_offset     = offset;
+			info.truncated       = chunk_size > size - offset;
+
+			return info;
+		}
+
+		offset += chunk_size + (chunk_size & 1); // Chunks are padded to an even size
+	}
+
+	printf("ERROR: WAV file does not contain a data chunk!\n");
+	return { };
+}
+
+template<typename Decode>
+static void decode_frames(int channels, unsigned char const * data, int bytes_per_sample, int num_frames, Sample * out, Decode decode) {
+	if (channels == 1) {
+		for (int i = 0; i < num_frames; i++) {
+			out[i] = decode(data + i * bytes_per_sample);
+		}
+	} else {
+		for (int i = 0; i < num_frames; i++) {
+			out[i].left  = decode(data + (2*i)     * bytes_per_sample);
+			out[i].right = decode(data + (2*i + 1) * bytes_per_sample);
+		}
+	}
+}
+
+void util::decode_wav_frames(WavInfo const & info, unsigned char const * file, int first_frame, int num_frames, Sample * out) {
+	auto data = file + info.data_offset + size_t(first_frame) * info.bytes_per_frame;
+	auto bytes_per_sample = info.bytes_per_frame / info.channels;
+
+	switch (info.format) {
+		case WavInfo::Format::PCM_U8: decode_frames(info.channels, data, bytes_per_sample, num_frames, out, [](unsigned char const * ptr) {
+			return float(int(*ptr) - 128) / 127.0f;
+		}); break;
+
+		case WavInfo::Format::PCM_S16: decode_frames(info.channels, data, bytes_per_sample, num_frames, out, [](unsigned char const * ptr) {
+			return float(read<int16_t>(ptr)) / float(INT16_MAX);
+		}); break;
+
+		case WavInfo::Format::PCM_S24: decode_frames(info.channels, data, bytes_per_sample, num_frames, out, [](unsigned char const * ptr) {
+			auto value = int32_t(uint32_t(ptr[0]) << 8 | uint32_t(ptr[1]) << 16 | uint32_t(ptr[2]) << 24) >> 8; // Sign extend
+			return float(value) / 8388607.0f;
+		}); break;
+
+		case WavInfo::Format::PCM_S32: decode_frames(info.channels, data, bytes_per_sample, num_frames, out, [](unsigned char const * ptr) {
+			return float(read<int32_t>(ptr)) / float(INT32_MAX);
+		}); break;
+
+		case WavInfo::Format::FLOAT_32: decode_frames(info.channels, data, bytes_per_sample, num_frames, out, [](unsigned char const * ptr) {
+			return read<float>(ptr);
+		}); break;
+	}
+}
+
+bool util::write_wav(char const * filename, Sample const * samples, int num_frames, int sample_rate) {
+	FILE * file; fopen_s(&file, filename, "wb");
+
+	if (file == nullptr) {
+		printf("ERROR: Unable to open file '%s' for writing!\n", filename);
+		return false;
+	}
+
+	auto write = [file](auto value) { fwrite(&value, sizeof(value), 1, file); };
+
+	auto data_size = uint32_t(num_frames * sizeof(Sample));
+
+	fwrite("RIFF", 4, 1, file); write(uint32_t(4 + 8 + 16 + 8 + data_size));
+	fwrite("WAVE", 4, 1, file);
+
+	fwrite("fmt ", 4, 1, file); write(uint32_t(16));
+	write(WAVE_FORMAT_IEEE_FLOAT);
+	write(uint16_t(2));
+	write(uint32_t(sample_rate));
+	write(uint32_t(sample_rate * sizeof(Sample)));
+	write(uint16_t(sizeof(Sample)));
+	write(uint16_t(32));
+
+	fwrite("data", 4, 1, file); write(data_size);
+	fwrite(samples, sizeof(Sample), num_frames, file);
+
+	auto success = ferror(file) == 0;
+
+	if (fclose(file) != 0 || !success) {
+		printf("ERROR: Unable to write file '%s'!\n", filename);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <optional>
+
+#include "synth/sample.h"
+
+namespace util {
+	// Layout of the audio data in a RIFF WAVE file
+	struct WavInfo {
+		enum struct Format { PCM_U8, PCM_S16, PCM_S24, PCM_S32, FLOAT_32 } format;
+
+		int channels;
+		int sample_rate;
+		int bytes_per_frame;
+		int num_frames;
+
+		size_t data_offset; // Offset of the first frame in bytes, relative to the start of the file
+
+		bool truncated; // The data chunk claims more frames than the file holds, num_frames only counts the frames that are present
+	};
+
+	// Parses the chunks of a WAV file held in memory, without touching the audio data itself
+	std::optional<WavInfo> parse_wav_header(unsigned char const * file, size_t size);
+
+	// Decodes frames [first_frame, first_frame + num_frames) to stereo floats, mono is copied to both channels
+	void decode_wav_frames(WavInfo const & info, unsigned char const * file, int first_frame, int num_frames, Sample * out);
+
+	// Writes stereo 32 bit float frames
+	bool write_wav(char const * filename, Sample const * samples, int num_frames, int sample_rate);
+}